@@ -2,6 +2,7 @@
 
 #include <llvm/IR/Value.h>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -78,10 +79,37 @@ public:
     std::string stringify(size_t indent_level = 0) override;
 };
 
+// @name or @name(arguments), written before the statement it applies to
+class AttributeAST {
+public:
+    SourceLocation loc;
+    std::string name;
+    std::vector<std::unique_ptr<ExprAST>> arguments;
+
+    AttributeAST(SourceLocation loc, std::string name, std::vector<std::unique_ptr<ExprAST>> arguments)
+        : loc{loc}, name{std::move(name)}, arguments{std::move(arguments)} {
+    }
+
+    std::string stringify(size_t indent_level = 0);
+};
+
+// @likely(condition) and @unlikely(condition), where the attribute wraps an expression instead of a statement
+class AttributedExprAST : public ExprAST {
+public:
+    AttributeAST attribute;
+
+    AttributedExprAST(SourceLocation loc, AttributeAST attribute) : ExprAST(loc), attribute{std::move(attribute)} {
+    }
+
+    std::string stringify(size_t indent_level = 0) override;
+};
+
 class FunctionAST : public DeclAST {
 public:
     std::vector<ParamDeclareAST> parameters;
     std::unique_ptr<BlockAST> body;
+    bool is_exported{false};
+    std::vector<AttributeAST> attributes;
 
     FunctionAST(SourceLocation loc, std::string name, std::vector<ParamDeclareAST> parameters, Type return_type,
                 std::unique_ptr<BlockAST> body)
@@ -149,6 +177,19 @@ public:
     std::string stringify(size_t indent_level) override;
 };
 
+// T(arguments), where T names a type
+class ConstructAST : public ExprAST {
+public:
+    Type type;
+    std::vector<std::unique_ptr<ExprAST>> arguments;
+
+    ConstructAST(SourceLocation loc, Type type, std::vector<std::unique_ptr<ExprAST>> arguments)
+        : ExprAST(loc), type{std::move(type)}, arguments{std::move(arguments)} {
+    }
+
+    std::string stringify(size_t indent_level) override;
+};
+
 class IfExprAST : public ExprAST {
 public:
     std::unique_ptr<ExprAST> condition;
@@ -188,6 +229,32 @@ public:
     std::string stringify(size_t indent_level = 0) override;
 };
 
+// [a, b, c] or [value; N]
+class ArrayLiteralAST : public ExprAST {
+public:
+    std::vector<std::unique_ptr<ExprAST>> elements;
+    std::optional<uint64_t> repeat_count; // Set for [value; N], where elements holds just the value
+
+    ArrayLiteralAST(SourceLocation loc, std::vector<std::unique_ptr<ExprAST>> elements,
+                    std::optional<uint64_t> repeat_count)
+        : ExprAST(loc), elements{std::move(elements)}, repeat_count{repeat_count} {
+    }
+
+    std::string stringify(size_t indent_level = 0) override;
+};
+
+class IndexExprAST : public ExprAST {
+public:
+    std::unique_ptr<ExprAST> base;
+    std::unique_ptr<ExprAST> index;
+
+    IndexExprAST(SourceLocation loc, std::unique_ptr<ExprAST> base, std::unique_ptr<ExprAST> index)
+        : ExprAST(loc), base{std::move(base)}, index{std::move(index)} {
+    }
+
+    std::string stringify(size_t indent_level = 0) override;
+};
+
 class AssignmentAST : public StmtAST {
 public:
     TokenType op;
@@ -202,17 +269,68 @@ public:
     std::string stringify(size_t indent_level = 0) override;
 };
 
+class IndexAssignmentAST : public StmtAST {
+public:
+    TokenType op;
+
+    std::unique_ptr<IndexExprAST> target;
+    std::unique_ptr<ExprAST> expr;
+
+    IndexAssignmentAST(SourceLocation loc, std::unique_ptr<IndexExprAST> target, TokenType op,
+                       std::unique_ptr<ExprAST> expr)
+        : StmtAST(loc), op{op}, target{std::move(target)}, expr{std::move(expr)} {
+    }
+
+    std::string stringify(size_t indent_level = 0) override;
+};
+
 // TODO: Maybe take a leaf out of Rust's book and make it an expr that can return stuff w/ break
 class WhileAST : public StmtAST { 
 public:
     std::unique_ptr<ExprAST> condition;
     std::unique_ptr<BlockAST> body;
+    std::vector<AttributeAST> attributes;
 
     WhileAST(SourceLocation loc, std::unique_ptr<ExprAST> condition, std::unique_ptr<BlockAST> body) : StmtAST(loc), condition{std::move(condition)}, body{std::move(body)} {}
 
     std::string stringify(size_t indent_level = 0) override;
 };
 
+// for variable in start..end step step { body }; end is exclusive and step defaults to 1
+class ForAST : public StmtAST {
+public:
+    std::string variable;
+    std::unique_ptr<ExprAST> start;
+    std::unique_ptr<ExprAST> end;
+    std::unique_ptr<ExprAST> step;
+    std::unique_ptr<BlockAST> body;
+    std::vector<AttributeAST> attributes;
+
+    ForAST(SourceLocation loc, std::string variable, std::unique_ptr<ExprAST> start, std::unique_ptr<ExprAST> end,
+           std::unique_ptr<ExprAST> step, std::unique_ptr<BlockAST> body)
+        : StmtAST(loc), variable{std::move(variable)}, start{std::move(start)}, end{std::move(end)},
+          step{std::move(step)}, body{std::move(body)} {
+    }
+
+    std::string stringify(size_t indent_level = 0) override;
+};
+
+class BreakAST : public StmtAST {
+public:
+    explicit BreakAST(SourceLocation loc) : StmtAST(loc) {
+    }
+
+    std::string stringify(size_t indent_level = 0) override;
+};
+
+class ContinueAST : public StmtAST {
+public:
+    explicit ContinueAST(SourceLocation loc) : StmtAST(loc) {
+    }
+
+    std::string stringify(size_t indent_level = 0) override;
+};
+
 class ReturnAST : public StmtAST {
 public:
     std::unique_ptr<ExprAST> value;
@@ -4,6 +4,7 @@
 #include <functional>
 
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
@@ -12,6 +13,8 @@
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Verifier.h"
 
+#include "chung/options.hpp"
+#include "chung/token.hpp"
 #include "chung/type.hpp"
 
 class ResolvedDecl;
@@ -22,17 +25,39 @@ struct Context {
     llvm::LLVMContext context;
     llvm::IRBuilder<> builder;
     llvm::Instruction* variable_insert_point; // alloca
+    llvm::BasicBlock* tail_recursion_block{nullptr}; // Self tail calls jump back here
+    FpContract fp_contract{FpContract::OFF}; // Of the function being generated. Fast math lives in builder's flags
+    std::vector<std::pair<llvm::BasicBlock*, llvm::BasicBlock*>> loop_targets; // {continue, break} of enclosing loops
     std::unique_ptr<llvm::Module> module;
-    std::map<ResolvedDecl*, llvm::Value*> named_values; // AllocaInst* and/or Argument*
+    std::vector<llvm::Value*> named_values; // Indexed by ResolvedDecl::slot; AllocaInst* for `mut`, SSA values otherwise
     std::map<std::string, Type> declared_types;
     std::map<std::reference_wrapper<const Type>, llvm::Type*, std::less<const Type>> llvm_types; // NOLINT
-    std::vector<std::string> c_builtins;
+    std::map<std::string, llvm::Constant*> string_literals; // Fat pointer constant of every pooled string literal
+
+    // Source locations on instructions, for optimization remarks and -g. Null unless enabled
+    std::unique_ptr<llvm::DIBuilder> debug_builder;
+    llvm::DICompileUnit* debug_unit{nullptr};
+    llvm::DIFile* debug_file{nullptr};
+    std::map<std::pair<unsigned, unsigned>, SourceLocation> debug_locations; // {line, column} of each DILocation
+    std::map<std::string, llvm::DIType*> debug_types;                        // By Type::name
 
     Context();
 
+    // Only -g (emit_dwarf) writes DWARF; otherwise the locations stay in the IR for remarks
+    void enable_debug_info(const std::string& file_path, bool emit_dwarf, bool is_optimized);
+    llvm::DIType* get_debug_type(const Type& type); // Null for void
+    void create_debug_function(llvm::Function* function, SourceLocation loc, const std::vector<Type>& signature);
+    void set_debug_location(SourceLocation loc); // For the instructions created after this
+    // A variable the debugger can show, either in memory (`mut`, an alloca) or as an SSA value. Parameters are
+    // numbered from 1, everything else is 0
+    void declare_debug_variable(const std::string& name, const Type& type, llvm::Value* value, bool in_memory,
+                                SourceLocation loc, unsigned argument = 0);
+
     Type get_type(const std::string& type_identifier);
+    llvm::Type* get_llvm_type(const Type& type);
 
     llvm::AllocaInst* allocate_stack_variable(std::string_view name, llvm::Type* type);
+    llvm::Constant* get_string_literal(const std::string& string);
 
     llvm::Value* load_value(llvm::Value* value, llvm::Type* type) {
         return builder.CreateLoad(type, value);
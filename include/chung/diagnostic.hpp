@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "chung/token.hpp"
+
+// The line loc is on between the lines around it, with the token highlighted in color and underlined with carets
+std::string write_snippet(const std::vector<std::string>& source_lines, const SourceLocation& loc, const char* color);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include "chung/token.hpp"
@@ -45,6 +46,9 @@ public:
 
     std::pair<std::vector<Token>, std::vector<LexException>> lex();
 
+    // Eats the '%', '!' or '?' after +, - or *, giving the matching overflow operator
+    std::optional<TokenType> lex_overflow_op(TokenType op);
+
 private:
     const std::string source;
     std::vector<std::string> source_lines;
@@ -2,5 +2,39 @@
 
 #include <cstdint>
 extern "C" {
+// Matches the layout of chung's string type. Strings are returned as this struct, but passed as separate pointer and
+// length arguments
+using str = struct {
+    char* sigma;
+    int64_t len;
+};
+
 void print(int64_t int64);
+void print_char(int64_t int64);
+void print_float64(double float64);
+void print_string(const char* sigma, int64_t len);
+str int64_to_string(int64_t int64);
+str float64_to_string(double float64);
+void flush();
+
+[[noreturn]] void panic_index_out_of_bounds(int64_t index, int64_t len, int64_t line);
+[[noreturn]] void panic_non_positive_step(int64_t step, int64_t line);
+[[noreturn]] void panic_division_by_zero(int64_t line);
+[[noreturn]] void panic_division_overflow(int64_t line);
+[[noreturn]] void panic_integer_overflow(int64_t line);
+[[noreturn]] void panic_negative_exponent(int64_t exponent, int64_t line);
+
+int64_t read_int64();
+double read_float64();
+str read_token();
+str read_line();
+str input(const char* prompt, int64_t prompt_len);
+bool stdin_eof();
+
+str read_file(const char* path, int64_t path_len);
+str map_file(const char* path, int64_t path_len);
+bool write_file(const char* path, int64_t path_len, const char* contents, int64_t contents_len);
+int64_t open_reader(const char* path, int64_t path_len);
+str read_chunk(int64_t reader);
+void close_reader(int64_t reader);
 }
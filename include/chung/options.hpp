@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// What integer +, - and * do when the result doesn't fit the type
+enum class OverflowMode : uint8_t {
+    WRAP,      // Two's complement wrap around, like C's unsigned arithmetic
+    UNDEFINED, // LLVM may assume it never happens (nsw/nuw), which is fastest but gives garbage if it does
+    TRAP,      // Checked, and the program panics when it happens
+};
+
+// When a * b + c may become a fused multiply-add, which rounds once instead of twice
+enum class FpContract : uint8_t {
+    OFF,  // Never, so results match strict IEEE arithmetic
+    ON,   // Within a single expression, through llvm.fmuladd
+    FAST, // Anywhere LLVM finds one, even across statements
+};
+
+// How freely float arithmetic may be rewritten. Set for the whole build, then per function by attributes
+struct FloatModel {
+    bool fast_math{false}; // Reassociation, contraction and assuming no NaNs, infinities or signed zeros
+    FpContract contract{FpContract::OFF};
+};
+
+// Flags passed to `chung parse` after the file
+struct CompileOptions {
+    OverflowMode overflow{OverflowMode::WRAP}; // --overflow=wrap|undefined|trap
+    FloatModel float_model;                    // --fast-math, --fp-contract=off|on|fast
+    unsigned opt_level{0};                     // -O0 to -O3
+    bool debug_info{false};                    // -g, DWARF with lines, columns, functions and variables
+    bool frame_pointers{false};                // -fno-omit-frame-pointer, so profilers can walk the stack cheaply
+
+    // Profile guided optimization. An instrumented build writes raw counts to profile_generate when it exits, which
+    // `llvm-profdata merge` turns into the file profile_use reads
+    std::optional<std::string> profile_generate; // --profile-generate[=<file>]
+    std::optional<std::string> profile_use;      // --profile-use=<file>
+
+    // Optimization remarks from the passes matching the regex, printed against the source and/or written as YAML
+    std::optional<std::string> remarks;        // --remarks=<pass regex>
+    std::optional<std::string> remarks_output; // --remarks-output=<file>
+};
+
+std::optional<FpContract> parse_fp_contract(const std::string& value);
+
+// Returns an error message for the first flag that isn't understood
+std::optional<std::string> parse_compile_options(const std::vector<std::string>& flags, CompileOptions& options);
@@ -85,17 +85,27 @@ public:
     std::unique_ptr<ExprAST> parse_unary();
     std::unique_ptr<ExprAST> parse_primitive();
     std::unique_ptr<ExprAST> parse_primary();
+    std::unique_ptr<ExprAST> parse_postfix(std::unique_ptr<ExprAST> expr);
+    std::unique_ptr<ExprAST> parse_array_literal();
+    uint64_t parse_array_length();
+    Type parse_type();
 
     // Statements
     std::unique_ptr<BlockAST> parse_block();
     std::unique_ptr<StmtAST> parse_var_declaration();
     std::unique_ptr<StmtAST> parse_function();
+    std::unique_ptr<StmtAST> parse_export();
     std::unique_ptr<StmtAST> parse_omg();
     std::unique_ptr<StmtAST> parse_return();
     std::unique_ptr<StmtAST> parse_expression_statement(bool require_semicolons);
 
     std::unique_ptr<ExprAST> parse_if_expr();
     std::unique_ptr<StmtAST> parse_while();
+    std::unique_ptr<StmtAST> parse_for();
+    std::unique_ptr<StmtAST> parse_loop_control();
+    std::vector<AttributeAST> parse_attributes();
+    std::unique_ptr<StmtAST> parse_attributed_statement();
+    std::unique_ptr<ExprAST> parse_attributed_expr();
 
     // Heheheha
     std::unique_ptr<ExprAST> parse_expression_or_assignment();
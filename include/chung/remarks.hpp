@@ -0,0 +1,51 @@
+#pragma once
+
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/Support/Regex.h>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chung/token.hpp"
+
+enum class RemarkKind : uint8_t {
+    PASSED,   // The optimization happened
+    MISSED,   // It was tried and didn't happen, e.g. a loop that wasn't vectorized
+    ANALYSIS, // Why, e.g. the dependence that stopped the vectorizer
+};
+
+// An LLVM optimization remark, mapped back to the chung code it's about
+struct Remark {
+    RemarkKind kind;
+    std::string pass;
+    std::string function;
+    std::string message;
+    std::optional<SourceLocation> loc; // Missing when the instruction it's about has no location
+
+    std::string write(const std::vector<std::string>& source_lines) const;
+};
+
+// Collects the remarks of passes whose name matches a regex, like LLVM's -pass-remarks. Locations are looked up in
+// Context::debug_locations, so the carets cover the whole token
+class RemarkCollector : public llvm::DiagnosticHandler {
+public:
+    RemarkCollector(const std::string& pass_regex,
+                    const std::map<std::pair<unsigned, unsigned>, SourceLocation>& locations,
+                    std::vector<Remark>& remarks)
+        : pass_regex{pass_regex}, locations{locations}, remarks{remarks} {
+    }
+
+    bool handleDiagnostics(const llvm::DiagnosticInfo& info) override;
+
+    bool isAnalysisRemarkEnabled(llvm::StringRef pass_name) const override;
+    bool isMissedOptRemarkEnabled(llvm::StringRef pass_name) const override;
+    bool isPassedOptRemarkEnabled(llvm::StringRef pass_name) const override;
+    bool isAnyRemarkEnabled() const override;
+
+private:
+    llvm::Regex pass_regex;
+    const std::map<std::pair<unsigned, unsigned>, SourceLocation>& locations;
+    std::vector<Remark>& remarks;
+};
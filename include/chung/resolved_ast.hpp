@@ -1,10 +1,12 @@
 #pragma once
 
 #include "chung/context.hpp"
+#include "chung/options.hpp"
 #include "chung/token.hpp"
 #include <llvm/IR/Value.h>
 #include <llvm/Support/ErrorHandling.h>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -62,6 +64,9 @@ public:
     std::string name;
     Type type;
 
+    // Index of the variable's value in Context::named_values, unique within the enclosing function
+    size_t slot{};
+
     ResolvedDecl(SourceLocation loc, std::string name, Type type)
         : ResolvedStmt(loc), name{std::move(name)}, type{std::move(type)} {
     }
@@ -94,11 +99,41 @@ public:
     llvm::Value* codegen(Context& ctx) override;
 };
 
+// What a function may do besides computing its return value. Defaults are the conservative answer
+struct FunctionEffects {
+    bool accesses_memory{true};        // Reads or writes memory visible to its callers, including any I/O
+    bool synchronizes{true};           // May synchronize with other threads (e.g. stdio locks)
+    bool will_return{false};           // Always returns (no unbounded loops or recursion)
+    bool accesses_runtime_state{true}; // Touches state chung code can't see, like malloc's or stdout's buffer
+};
+
 class ResolvedFunction : public ResolvedDecl {
 public:
     std::vector<std::unique_ptr<ResolvedParamDeclare>> parameters;
     std::unique_ptr<ResolvedBlock> body;
 
+    // Set by Sema if the function calls itself in tail position; codegen turns those calls into a loop
+    bool is_tail_recursive{false};
+
+    // Exported functions (and main) keep external linkage and the C calling convention
+    bool is_exported{false};
+    bool is_builtin{false};
+    bool is_hot{false};  // @hot
+    bool is_cold{false}; // @cold
+
+    // Number of parameters and local variables, i.e. the size of Context::named_values while generating the body
+    size_t num_slots{};
+    llvm::Function* llvm_function{nullptr};
+
+    // Recorded by Sema while resolving the body, then folded into `effects` by Sema::infer_effects
+    std::vector<const ResolvedFunction*> callees;
+    bool has_loops{false};           // `while` loops only; range loops always terminate
+    bool has_memory_accesses{false}; // Indexes into arrays, slices or strings
+    bool has_traps{false};           // Contains runtime checks that abort the program when they fail
+    FunctionEffects effects;
+
+    FloatModel float_model; // The build's, unless @fastmath or @fp_contract say otherwise
+
     ResolvedFunction(SourceLocation loc, std::string name,
                      std::vector<std::unique_ptr<ResolvedParamDeclare>> parameters, Type return_type,
                      std::unique_ptr<ResolvedBlock> body)
@@ -107,6 +142,7 @@ public:
     }
 
     // std::string stringify(size_t indent_level = 0) override;
+    llvm::Function* declare(Context& ctx);
     llvm::Value* codegen(Context& ctx) override;
 };
 
@@ -137,6 +173,7 @@ class ResolvedUnaryExpr : public ResolvedExpr {
 public:
     TokenType op;
     std::unique_ptr<ResolvedExpr> expr;
+    OverflowMode overflow{OverflowMode::WRAP}; // Only matters for integer negation
 
     ResolvedUnaryExpr(SourceLocation loc, TokenType op, std::unique_ptr<ResolvedExpr> expr)
         : ResolvedExpr(loc, expr->type), op{op}, expr{std::move(expr)} {
@@ -151,6 +188,7 @@ public:
     TokenType op;
     std::unique_ptr<ResolvedExpr> lhs;
     std::unique_ptr<ResolvedExpr> rhs;
+    OverflowMode overflow{OverflowMode::WRAP}; // Only matters for integer +, - and *
 
     ResolvedBinaryExpr(SourceLocation loc, TokenType op, Type type, std::unique_ptr<ResolvedExpr> lhs,
                        std::unique_ptr<ResolvedExpr> rhs)
@@ -161,11 +199,39 @@ public:
     llvm::Value* codegen(Context& ctx) override;
 };
 
+// @likely(condition) or @unlikely(condition). Branches on it get branch weights, and anywhere else it's llvm.expect
+class ResolvedExpect : public ResolvedExpr {
+public:
+    std::unique_ptr<ResolvedExpr> condition;
+    bool likely;
+
+    ResolvedExpect(SourceLocation loc, std::unique_ptr<ResolvedExpr> condition, bool likely)
+        : ResolvedExpr(loc, Type::boolean), condition{std::move(condition)}, likely{likely} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+// Numeric conversion, either written as T(x) or inserted by Sema to widen a value. Vectors convert lane by lane
+class ResolvedCast : public ResolvedExpr {
+public:
+    std::unique_ptr<ResolvedExpr> expr;
+
+    ResolvedCast(SourceLocation loc, Type type, std::unique_ptr<ResolvedExpr> expr)
+        : ResolvedExpr(loc, std::move(type)), expr{std::move(expr)} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
 class ResolvedCall : public ResolvedExpr {
 public:
     const ResolvedFunction* callee;
     std::vector<std::unique_ptr<ResolvedExpr>> arguments;
 
+    // Set by Sema if the call's value is directly returned from the enclosing function
+    bool is_tail_call{false};
+
     ResolvedCall(SourceLocation loc, const ResolvedFunction& callee,
                  std::vector<std::unique_ptr<ResolvedExpr>> arguments)
         : ResolvedExpr(loc, callee.type), callee{&callee}, arguments{std::move(arguments)} {
@@ -201,6 +267,7 @@ public:
         bool boolean;
     };
     std::string string;
+    bool is_untyped{false}; // A number without a type suffix, which takes on any numeric type its value fits in
 
     ResolvedPrimitive(SourceLocation loc) : ResolvedExpr(loc, Type::invalid) {
     }
@@ -232,11 +299,136 @@ public:
     llvm::Value* codegen(Context& ctx) override;
 };
 
+class ResolvedArrayLiteral : public ResolvedExpr {
+public:
+    std::vector<std::unique_ptr<ResolvedExpr>> elements;
+    bool is_repeat; // [value; N]: elements holds just the value
+
+    ResolvedArrayLiteral(SourceLocation loc, Type type, std::vector<std::unique_ptr<ResolvedExpr>> elements,
+                         bool is_repeat)
+        : ResolvedExpr(loc, std::move(type)), elements{std::move(elements)}, is_repeat{is_repeat} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+class ResolvedIndex : public ResolvedExpr {
+public:
+    std::unique_ptr<ResolvedExpr> base;
+    std::unique_ptr<ResolvedExpr> index;
+
+    // Cleared by Sema when the index is provably in bounds
+    bool needs_bounds_check{true};
+
+    ResolvedIndex(SourceLocation loc, Type type, std::unique_ptr<ResolvedExpr> base,
+                  std::unique_ptr<ResolvedExpr> index)
+        : ResolvedExpr(loc, std::move(type)), base{std::move(base)}, index{std::move(index)} {
+    }
+
+    // Bounds checked address of the element
+    llvm::Value* codegen_address(Context& ctx);
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+// len(x) for strings, arrays and slices
+class ResolvedLen : public ResolvedExpr {
+public:
+    std::unique_ptr<ResolvedExpr> expr;
+
+    ResolvedLen(SourceLocation loc, std::unique_ptr<ResolvedExpr> expr)
+        : ResolvedExpr(loc, Type::int64), expr{std::move(expr)} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+// float64x4(a, b, c, d), or float64x4(x) to put x in every lane
+class ResolvedVectorLiteral : public ResolvedExpr {
+public:
+    std::vector<std::unique_ptr<ResolvedExpr>> elements; // One per lane, or a single element to splat
+
+    ResolvedVectorLiteral(SourceLocation loc, Type type, std::vector<std::unique_ptr<ResolvedExpr>> elements)
+        : ResolvedExpr(loc, std::move(type)), elements{std::move(elements)} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+// Vector builtins, each a single LLVM instruction or intrinsic
+enum class VectorOp : uint8_t {
+    SHUFFLE,    // shuffle(a, lanes...), shuffle(a, b, lanes...)
+    SELECT,     // select(mask, a, b)
+    EXTRACT,    // extract(v, lane)
+    INSERT,     // insert(v, lane, value)
+    REDUCE_ADD, // reduce_add(v) etc. fold the lanes into a scalar
+    REDUCE_MUL,
+    REDUCE_MIN,
+    REDUCE_MAX,
+    REDUCE_ANY, // Masks only
+    REDUCE_ALL
+};
+
+class ResolvedVectorOp : public ResolvedExpr {
+public:
+    VectorOp op;
+    std::vector<std::unique_ptr<ResolvedExpr>> operands; // Vector (and value) operands; lane literals are in `lanes`
+    std::vector<int> lanes;                               // The shuffle mask, or the lane to extract or insert
+
+    ResolvedVectorOp(SourceLocation loc, Type type, VectorOp op, std::vector<std::unique_ptr<ResolvedExpr>> operands,
+                     std::vector<int> lanes)
+        : ResolvedExpr(loc, std::move(type)), op{op}, operands{std::move(operands)}, lanes{std::move(lanes)} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+// Builtins that lower straight to an LLVM intrinsic rather than a prelude call, so LLVM can constant fold and vectorize
+// them. All of them work lane by lane on vectors
+enum class IntrinsicOp : uint8_t {
+    SQRT, // sqrt(x) through round(x) take floats
+    SIN,
+    COS,
+    EXP,
+    EXP2,
+    LOG,
+    LOG2,
+    LOG10,
+    FLOOR,
+    CEIL,
+    TRUNC,
+    ROUND,    // Halfway cases round away from zero
+    FMA,      // fma(a, b, c) is a * b + c, rounded once
+    COPYSIGN, // copysign(magnitude, sign)
+    ABS,      // abs, min and max take integers or floats
+    MIN,
+    MAX,
+    POPCOUNT, // The rest take integers. popcount, clz and ctz count bits, giving the bit width for clz(0) and ctz(0)
+    CLZ,
+    CTZ,
+    BSWAP, // Reverses the bytes, so needs at least 16 bits
+    ROTL,  // rotl(x, n), where n wraps around the bit width
+    ROTR
+};
+
+class ResolvedIntrinsic : public ResolvedExpr {
+public:
+    IntrinsicOp op;
+    std::vector<std::unique_ptr<ResolvedExpr>> operands;
+
+    ResolvedIntrinsic(SourceLocation loc, Type type, IntrinsicOp op,
+                      std::vector<std::unique_ptr<ResolvedExpr>> operands)
+        : ResolvedExpr(loc, std::move(type)), op{op}, operands{std::move(operands)} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
 class ResolvedAssignment : public ResolvedStmt {
 public:
     TokenType op;
     std::unique_ptr<ResolvedVariable> variable;
     std::unique_ptr<ResolvedExpr> expr;
+    OverflowMode overflow{OverflowMode::WRAP};
 
     ResolvedAssignment(SourceLocation loc, std::unique_ptr<ResolvedVariable> variable, TokenType op,
                        std::unique_ptr<ResolvedExpr> expr)
@@ -246,10 +438,37 @@ public:
     llvm::Value* codegen(Context& ctx) override;
 };
 
+class ResolvedIndexAssignment : public ResolvedStmt {
+public:
+    TokenType op;
+    std::unique_ptr<ResolvedIndex> target;
+    std::unique_ptr<ResolvedExpr> expr;
+    OverflowMode overflow{OverflowMode::WRAP};
+
+    ResolvedIndexAssignment(SourceLocation loc, std::unique_ptr<ResolvedIndex> target, TokenType op,
+                            std::unique_ptr<ResolvedExpr> expr)
+        : ResolvedStmt(loc), op{op}, target{std::move(target)}, expr{std::move(expr)} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+// Optimizer hints from loop attributes, emitted as llvm.loop metadata. Unset fields leave the decision to LLVM
+struct LoopHints {
+    std::optional<bool> unroll;     // @unroll, @unroll(disable)
+    bool unroll_full{false};        // @unroll(full)
+    uint64_t unroll_count{};        // @unroll(N)
+    std::optional<bool> vectorize;  // @vectorize, @vectorize(disable)
+    uint64_t vectorize_width{};     // @vectorize(N)
+    uint64_t interleave_count{};    // @interleave(N)
+    bool distribute{false};         // @distribute
+};
+
 class ResolvedWhile : public ResolvedStmt {
 public:
     std::unique_ptr<ResolvedExpr> condition;
     std::unique_ptr<ResolvedBlock> body;
+    LoopHints hints;
 
     ResolvedWhile(SourceLocation loc, std::unique_ptr<ResolvedExpr> condition, std::unique_ptr<ResolvedBlock> body)
         : ResolvedStmt(loc), condition{std::move(condition)}, body{std::move(body)} {
@@ -258,6 +477,46 @@ public:
     llvm::Value* codegen(Context& ctx) override;
 };
 
+// Counted loop over [start, end). The induction variable is an immutable binding to a phi, so LLVM sees a canonical
+// loop with a computable trip count
+class ResolvedFor : public ResolvedStmt {
+public:
+    std::unique_ptr<ResolvedVarDeclare> variable; // No initializer; codegen binds its slot to the phi
+    std::unique_ptr<ResolvedExpr> start;
+    std::unique_ptr<ResolvedExpr> end;
+    std::unique_ptr<ResolvedExpr> step; // nullptr for a step of 1
+    std::unique_ptr<ResolvedBlock> body;
+    LoopHints hints;
+
+    // Cleared by Sema when the step is a literal, which it has already checked to be positive
+    bool needs_step_check{true};
+
+    ResolvedFor(SourceLocation loc, std::unique_ptr<ResolvedVarDeclare> variable, std::unique_ptr<ResolvedExpr> start,
+                std::unique_ptr<ResolvedExpr> end, std::unique_ptr<ResolvedExpr> step,
+                std::unique_ptr<ResolvedBlock> body)
+        : ResolvedStmt(loc), variable{std::move(variable)}, start{std::move(start)}, end{std::move(end)},
+          step{std::move(step)}, body{std::move(body)} {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+class ResolvedBreak : public ResolvedStmt {
+public:
+    explicit ResolvedBreak(SourceLocation loc) : ResolvedStmt(loc) {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
+class ResolvedContinue : public ResolvedStmt {
+public:
+    explicit ResolvedContinue(SourceLocation loc) : ResolvedStmt(loc) {
+    }
+
+    llvm::Value* codegen(Context& ctx) override;
+};
+
 class ResolvedReturn : public ResolvedStmt {
 public:
     std::unique_ptr<ResolvedExpr> value;
@@ -6,6 +6,7 @@
 
 #include "ast.hpp"
 #include "chung/error.hpp"
+#include "chung/options.hpp"
 #include "chung/token.hpp"
 #include "resolved_ast.hpp"
 
@@ -20,6 +21,13 @@ public:
     std::string write(const std::vector<std::string>& source_lines) override;
 };
 
+// A range loop whose body is being resolved
+struct InductionRange {
+    const ResolvedDecl* variable;
+    const ResolvedExpr* end;
+    bool non_negative_start;
+};
+
 class Sema {
 private:
     std::vector<SemaException> exceptions;
@@ -27,43 +35,75 @@ private:
 public:
     std::vector<std::unique_ptr<StmtAST>> ast;
     const std::vector<std::string>& source_lines;
+    CompileOptions options;
 
     // 1 scope = std::vector<ResolvedDecl*>, multiple will be a chain
     std::vector<std::vector<ResolvedDecl*>> scopes;
 
     ResolvedFunction* current_function{nullptr};
 
-    explicit Sema(std::vector<std::unique_ptr<StmtAST>> ast, const std::vector<std::string>& source_lines)
-        : ast{std::move(ast)}, source_lines{source_lines} {
+    // Innermost last
+    std::vector<InductionRange> induction_ranges;
+    size_t loop_depth{}; // Loops enclosing the statement being resolved, for break and continue
+
+    explicit Sema(std::vector<std::unique_ptr<StmtAST>> ast, const std::vector<std::string>& source_lines,
+                  CompileOptions options = {})
+        : ast{std::move(ast)}, source_lines{source_lines}, options{options} {
     }
 
     std::pair<std::vector<std::unique_ptr<ResolvedStmt>>, std::vector<std::unique_ptr<ResolvedStmt>>> resolve();
     std::unique_ptr<ResolvedStmt> resolve_stmt(const StmtAST& stmt);
-    std::unique_ptr<ResolvedCall> resolve_call(const CallAST& call);
+    std::unique_ptr<ResolvedExpr> resolve_call(const CallAST& call);
+    std::unique_ptr<ResolvedLen> resolve_len(const CallAST& call);
+    std::unique_ptr<ResolvedExpr> resolve_construct(const ConstructAST& construct);
+    std::unique_ptr<ResolvedVectorOp> resolve_vector_op(const CallAST& call, VectorOp op);
+    std::unique_ptr<ResolvedIntrinsic> resolve_intrinsic(const CallAST& call, IntrinsicOp op);
+    std::optional<int> resolve_lane(const ExprAST& lane, uint64_t num_lanes);
     std::unique_ptr<ResolvedBinaryExpr> resolve_binop(const BinaryExprAST& binop);
     std::unique_ptr<ResolvedFunction> resolve_function(const FunctionAST& function);
+    bool resolve_function_attributes(const std::vector<AttributeAST>& attributes, ResolvedFunction& function);
     std::unique_ptr<ResolvedParamDeclare> resolve_param_decl(const ParamDeclareAST& param);
     std::unique_ptr<ResolvedVarDeclare> resolve_var_decl(const VarDeclareAST& var_decl);
     std::unique_ptr<ResolvedBlock> resolve_block(const BlockAST& block);
     std::unique_ptr<ResolvedExpr> resolve_expr(const ExprAST& expr);
     std::unique_ptr<ResolvedExpr> resolve_expr_stmt(const ExprStmtAST& expr_stmt);
     std::unique_ptr<ResolvedIfExpr> resolve_if_expr(const IfExprAST& if_expr);
-    std::unique_ptr<ResolvedUnaryExpr> resolve_unary_expr(const UnaryExprAST& unary_expr);
+    std::unique_ptr<ResolvedExpr> resolve_unary_expr(const UnaryExprAST& unary_expr);
+    std::unique_ptr<ResolvedExpect> resolve_attributed_expr(const AttributedExprAST& attributed_expr);
     std::unique_ptr<ResolvedBinaryExpr> resolve_binary_expr(const BinaryExprAST& binary_expr);
+    std::unique_ptr<ResolvedBinaryExpr> resolve_power(const BinaryExprAST& power, std::unique_ptr<ResolvedExpr> base,
+                                                      std::unique_ptr<ResolvedExpr> exponent);
     std::unique_ptr<ResolvedVariable> resolve_variable(const VariableAST& variable);
     std::unique_ptr<ResolvedAssignment> resolve_assignment(const AssignmentAST& assignment);
     std::unique_ptr<ResolvedWhile> resolve_while(const WhileAST& while_loop);
+    std::unique_ptr<ResolvedFor> resolve_for(const ForAST& for_loop);
+    std::optional<LoopHints> resolve_loop_hints(const std::vector<AttributeAST>& attributes);
+    std::unique_ptr<ResolvedBlock> resolve_loop_body(const BlockAST& body);
     std::unique_ptr<ResolvedReturn> resolve_return(const ReturnAST& return_stmt);
+    std::unique_ptr<ResolvedArrayLiteral> resolve_array_literal(const ArrayLiteralAST& array_literal);
+    std::unique_ptr<ResolvedIndex> resolve_index_expr(const IndexExprAST& index_expr);
+    std::unique_ptr<ResolvedIndexAssignment> resolve_index_assignment(const IndexAssignmentAST& assignment);
+    std::unique_ptr<ResolvedPrimitive> resolve_primitive(const PrimitiveAST& primitive);
+    std::unique_ptr<ResolvedPrimitive> resolve_number(const PrimitiveAST& number, bool negate = false);
+    std::unique_ptr<ResolvedExpr> convert_implicitly(std::unique_ptr<ResolvedExpr> expr, const Type& to);
+
+    bool check_operands(TokenType op, const Type& type, const ResolvedExpr& rhs, OverflowMode overflow,
+                        SourceLocation loc);
+    bool is_induction_in_bounds(const ResolvedExpr& base, const ResolvedExpr& index);
+    void mark_tail_calls(ResolvedExpr& expr);
+    static void infer_effects(std::vector<std::unique_ptr<ResolvedStmt>>& resolved_ast);
 
     static std::unique_ptr<ResolvedOmg> resolve_omg(const OmgAST& block);
-    static std::unique_ptr<ResolvedPrimitive> resolve_primitive(const PrimitiveAST& primitive);
     static std::optional<Type> resolve_type(Type parsed_type);
+    static bool is_assignable(const Type& from, const Type& to);
+    static bool is_widening(const Type& from, const Type& to);
 
     std::pair<ResolvedDecl*, int> lookup_declaration(const std::string& name);
     bool add_declaration(ResolvedDecl& decl);
 
     void generate_std_function(std::vector<std::unique_ptr<ResolvedStmt>>& std_resolved_ast, const std::string& name,
-                          const std::vector<std::pair<std::string, Type>>& params, const Type& return_type);
+                               const std::vector<std::pair<std::string, Type>>& params, const Type& return_type,
+                               FunctionEffects effects = {});
     std::vector<std::unique_ptr<ResolvedStmt>> fill_std_functions();
 
     // Scopes
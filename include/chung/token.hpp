@@ -22,18 +22,37 @@ enum class TokenType : uint8_t {
     NOT,
     BITWISE_AND,
     BITWISE_OR,
+    BITWISE_XOR,
     BITWISE_NOT,
+    SHIFT_LEFT,
+    SHIFT_RIGHT,
+    ADD_WRAP, // +% -% *% wrap around on overflow
+    SUB_WRAP,
+    MUL_WRAP,
+    ADD_UNCHECKED, // +! -! *! assume overflow never happens
+    SUB_UNCHECKED,
+    MUL_UNCHECKED,
+    ADD_CHECKED, // +? -? *? panic on overflow
+    SUB_CHECKED,
+    MUL_CHECKED,
     ASSIGN,
     ADD_ASSIGN,
     SUB_ASSIGN,
     MUL_ASSIGN,
     DIV_ASSIGN,
+    MOD_ASSIGN,
+    BITWISE_AND_ASSIGN,
+    BITWISE_OR_ASSIGN,
+    BITWISE_XOR_ASSIGN,
+    SHIFT_LEFT_ASSIGN,
+    SHIFT_RIGHT_ASSIGN,
 
     GREATER_THAN,
     LESS_THAN,
     GREATER_EQUAL,
     LESS_EQUAL,
     EQUAL,
+    NOT_EQUAL,
 
     OPEN_PARENTHESES,
     CLOSE_PARENTHESES,
@@ -43,9 +62,11 @@ enum class TokenType : uint8_t {
     CLOSE_BRACES,
     ARROW,
     DOT,
+    RANGE,
     COMMA,
     COLON,
     SEMICOLON,
+    AT,
 
     FUNC,
     LET,
@@ -54,6 +75,11 @@ enum class TokenType : uint8_t {
     IF,
     ELSE,
     WHILE,
+    FOR,
+    IN,
+    BREAK,
+    CONTINUE,
+    EXPORT,
     __OMG,
 
     // Primitives
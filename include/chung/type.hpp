@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -10,12 +11,22 @@ enum class Ty : uint8_t {
 
     INVALID,
 
+    UINT8,
+    UINT16,
+    UINT32,
     UINT64,
+    INT8,
+    INT16,
+    INT32,
     INT64,
+    FLOAT32,
     FLOAT64,
     STRING,
     BOOL,
     VOID,
+    ARRAY, // [T; N], owns its N elements
+    SLICE, // []T, a view into someone else's elements
+    VECTOR, // float64x4 etc., a SIMD register's worth of lanes
     USER
 };
 
@@ -24,12 +35,24 @@ public:
     Ty ty;
     std::string name;
 
+    // Arrays, slices and vectors only. Arrays and slices are {ptr, len} fat pointers at runtime, like strings; vectors
+    // are LLVM fixed vectors of `length` lanes
+    std::shared_ptr<const Type> element;
+    uint64_t length{};
+
     // Default values
     static Type none;
     static Type invalid;
 
+    static Type uint8;
+    static Type uint16;
+    static Type uint32;
     static Type uint64;
+    static Type int8;
+    static Type int16;
+    static Type int32;
     static Type int64;
+    static Type float32;
     static Type float64;
     static Type string;
     static Type void_;
@@ -39,6 +62,73 @@ public:
         return {Ty::USER, std::move(name)};
     }
 
+    static Type array(const Type& element, uint64_t length) {
+        Type type{Ty::ARRAY, "[" + element.name + "; " + std::to_string(length) + "]"};
+        type.element = std::make_shared<const Type>(element);
+        type.length = length;
+        return type;
+    }
+
+    static Type slice(const Type& element) {
+        Type type{Ty::SLICE, "[]" + element.name};
+        type.element = std::make_shared<const Type>(element);
+        return type;
+    }
+
+    // Named after the element type, e.g. float64x4; vectors of bool are comparison masks
+    static Type vector(const Type& element, uint64_t lanes) {
+        Type type{Ty::VECTOR, element.name + "x" + std::to_string(lanes)};
+        type.element = std::make_shared<const Type>(element);
+        type.length = lanes;
+        return type;
+    }
+
+    bool is_array_like() const {
+        return ty == Ty::ARRAY || ty == Ty::SLICE;
+    }
+
+    bool is_vector() const {
+        return ty == Ty::VECTOR;
+    }
+
+    bool is_signed_integer() const {
+        return ty == Ty::INT8 || ty == Ty::INT16 || ty == Ty::INT32 || ty == Ty::INT64;
+    }
+
+    bool is_unsigned_integer() const {
+        return ty == Ty::UINT8 || ty == Ty::UINT16 || ty == Ty::UINT32 || ty == Ty::UINT64;
+    }
+
+    bool is_integer() const {
+        return is_signed_integer() || is_unsigned_integer();
+    }
+
+    bool is_float() const {
+        return ty == Ty::FLOAT32 || ty == Ty::FLOAT64;
+    }
+
+    bool is_numeric() const {
+        return is_integer() || is_float();
+    }
+
+    // Numeric types only
+    unsigned bit_width() const {
+        switch (ty) {
+            case Ty::UINT8:
+            case Ty::INT8:
+                return 8;
+            case Ty::UINT16:
+            case Ty::INT16:
+                return 16;
+            case Ty::UINT32:
+            case Ty::INT32:
+            case Ty::FLOAT32:
+                return 32;
+            default:
+                return 64;
+        }
+    }
+
     Type(Ty ty, std::string name) : ty{ty}, name{std::move(name)} {};
 
     // Needed for std::map and comparisons??
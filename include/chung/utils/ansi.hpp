@@ -2,6 +2,7 @@
 
 #define ANSI_RED "\033[1;31m"
 #define ANSI_GREEN "\033[1;32m"
+#define ANSI_YELLOW "\033[1;33m"
 #define ANSI_BLUE "\033[1;34m"
 #define ANSI_CYAN "\033[1;36m"
 #define ANSI_WHITE "\033[1;37m"
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <filesystem>
 
@@ -10,10 +12,17 @@
 #include "llvm/Target/TargetOptions.h"
 
 #include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMRemarkStreamer.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/PGOOptions.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/VirtualFileSystem.h"
 
 #include "chung/file.hpp"
 #include "chung/lexer.hpp"
+#include "chung/options.hpp"
 #include "chung/parser.hpp"
+#include "chung/remarks.hpp"
 #include "chung/sema.hpp"
 
 #include "chung/stringify.hpp"
@@ -35,13 +44,64 @@ void run_help() {
     std::cout << "Usage:\n";
     std::cout << "    chung [command] [options]\n\n";
     std::cout << "Commands:\n";
-    std::cout << "    chung parse <file.chung>   Lexes and parses the file, then dumps the AST\n";
+    std::cout << "    chung parse <file.chung>   Lexes and parses the file, then dumps the AST\n\n";
+    std::cout << "Options:\n";
+    std::cout << "    --overflow=wrap|undefined|trap   What integer +, - and * do on overflow (default: wrap)\n";
+    std::cout << "    --fast-math                      Lets LLVM rewrite float arithmetic as if it were exact\n";
+    std::cout << "    --fp-contract=off|on|fast        Where a * b + c may become an fma (default: off)\n";
+    std::cout << "    -O0|-O1|-O2|-O3                  Optimization level (default: -O0)\n";
+    std::cout << "    -g                               Emits DWARF debug info for debuggers and profilers\n";
+    std::cout << "    -fno-omit-frame-pointer          Keeps frame pointers, so perf can unwind without DWARF\n";
+    std::cout << "    --profile-generate[=<file>]      Instruments the program to write a profile when it exits\n";
+    std::cout << "    --profile-use=<file>             Optimizes using a profile merged by llvm-profdata\n";
+    std::cout << "    --remarks=<pass regex>           Shows what the matching passes did or couldn't do\n";
+    std::cout << "    --remarks-output=<file>          Writes the remarks to a YAML file\n";
+}
+
+// Runs LLVM's default pipeline for the -O level. With a PGO option it also inserts the profile counters, or reads
+// the merged profile back so branch weights, inlining and block layout follow what the program actually did
+void optimize_module(Context& ctx, llvm::TargetMachine* target_machine, const CompileOptions& options) {
+    std::optional<llvm::PGOOptions> pgo_options;
+    if (options.profile_generate) {
+        pgo_options = llvm::PGOOptions{*options.profile_generate, "", "", "", llvm::vfs::getRealFileSystem(),
+                                       llvm::PGOOptions::IRInstr};
+    } else if (options.profile_use) {
+        pgo_options = llvm::PGOOptions{*options.profile_use, "", "", "", llvm::vfs::getRealFileSystem(),
+                                       llvm::PGOOptions::IRUse};
+    }
+
+    llvm::LoopAnalysisManager loop_analyses;
+    llvm::FunctionAnalysisManager function_analyses;
+    llvm::CGSCCAnalysisManager cgscc_analyses;
+    llvm::ModuleAnalysisManager module_analyses;
+
+    llvm::PassBuilder pass_builder{target_machine, llvm::PipelineTuningOptions{}, pgo_options};
+    pass_builder.registerModuleAnalyses(module_analyses);
+    pass_builder.registerCGSCCAnalyses(cgscc_analyses);
+    pass_builder.registerFunctionAnalyses(function_analyses);
+    pass_builder.registerLoopAnalyses(loop_analyses);
+    pass_builder.crossRegisterProxies(loop_analyses, function_analyses, cgscc_analyses, module_analyses);
+
+    const llvm::OptimizationLevel* levels[]{&llvm::OptimizationLevel::O0, &llvm::OptimizationLevel::O1,
+                                            &llvm::OptimizationLevel::O2, &llvm::OptimizationLevel::O3};
+    const llvm::OptimizationLevel& level = *levels[options.opt_level];
+
+    llvm::ModulePassManager module_passes = level == llvm::OptimizationLevel::O0
+                                                ? pass_builder.buildO0DefaultPipeline(level)
+                                                : pass_builder.buildPerModuleDefaultPipeline(level);
+    module_passes.run(*ctx.module, module_analyses);
 }
 
 int run_parse(std::vector<std::string>& args) {
     std::cout << ANSI_BOLD << "Running Chungussy " << chung_ver_string() << '\n' << ANSI_RESET;
-    if (args.size() != 2) {
-        std::cerr << ANSI_RED << "Expected 1 argument, received " << args.size() - 1 << '\n' << ANSI_RESET;
+    if (args.size() < 2) {
+        std::cerr << ANSI_RED << "Expected a file to compile\n" << ANSI_RESET;
+        std::exit(1);
+    }
+
+    CompileOptions options;
+    if (auto error = parse_compile_options({args.begin() + 2, args.end()}, options)) {
+        std::cerr << ANSI_RED << *error << '\n' << ANSI_RESET;
         std::exit(1);
     }
 
@@ -50,6 +110,16 @@ int run_parse(std::vector<std::string>& args) {
         std::cerr << ANSI_RED << "File not found: \"" << file_path << "\" cannot be located" << '\n' << ANSI_RESET;
         std::exit(1);
     }
+    std::string regex_error;
+    if (options.remarks && !llvm::Regex{*options.remarks}.isValid(regex_error)) {
+        std::cerr << ANSI_RED << "Invalid remarks regex: " << regex_error << '\n' << ANSI_RESET;
+        std::exit(1);
+    }
+    if (options.profile_use && !file_exists(*options.profile_use)) {
+        std::cerr << ANSI_RED << "Profile not found: \"" << *options.profile_use << "\" cannot be located" << '\n'
+                  << ANSI_RESET;
+        std::exit(1);
+    }
     std::cout << "Lexing " << file_path << '\n';
 
     Context ctx{};
@@ -111,7 +181,7 @@ int run_parse(std::vector<std::string>& args) {
         std::cout << ANSI_CYAN << "==============================================\n" << ANSI_RESET << '\n';
         std::cout << "Analyzing and Type Checking " << file_path << '\n';
 
-        Sema sema{std::move(statements), source_lines};
+        Sema sema{std::move(statements), source_lines, options};
         const auto& [resolved_std_ast, resolved_ast] = sema.resolve();
         auto sema_exceptions = sema.get_exceptions();
 
@@ -125,9 +195,33 @@ int run_parse(std::vector<std::string>& args) {
             std::cout << ANSI_GREEN << "Successfully analyzed with no exceptions!\n\n" << ANSI_RESET;
         }
 
+        // Remarks need source locations on the instructions they're about, -g needs them in the object file
+        if (options.debug_info || options.remarks || options.remarks_output) {
+            ctx.enable_debug_info(file_path, options.debug_info, options.opt_level > 0);
+        }
+
+        // Declare every function up front so calls can refer to functions defined later in the file
+        for (const auto* statements : {&resolved_std_ast, &resolved_ast}) {
+            for (const auto& statement : *statements) {
+                if (auto* function = dynamic_cast<ResolvedFunction*>(statement.get())) {
+                    function->declare(ctx);
+                }
+            }
+        }
+
         for (const auto& resolved_statement : resolved_ast) {
             llvm::Value* statement_value = resolved_statement->codegen(ctx);
         }
+        if (ctx.debug_builder) {
+            ctx.debug_builder->finalize();
+        }
+        if (options.frame_pointers) {
+            for (llvm::Function& function : *ctx.module) {
+                if (!function.isDeclaration()) {
+                    function.addFnAttr("frame-pointer", "all");
+                }
+            }
+        }
 
         std::cout << ANSI_CYAN << "==============================================\n" << ANSI_RESET;
         std::cout << ANSI_BOLD << "      Module IR (temporary trust me bro)      \n" << ANSI_RESET;
@@ -157,14 +251,40 @@ int run_parse(std::vector<std::string>& args) {
         std::string cpu{"generic"};
         std::string features{};
 
-        llvm::TargetOptions options;
+        llvm::TargetOptions target_options;
 
         auto rm = std::optional<llvm::Reloc::Model>(llvm::Reloc::PIC_);
-        auto* target_machine = target->createTargetMachine(triple, cpu, features, options, rm);
+        auto codegen_level = *llvm::CodeGenOpt::getLevel(static_cast<int>(options.opt_level));
+        auto* target_machine =
+            target->createTargetMachine(triple, cpu, features, target_options, rm, std::nullopt, codegen_level);
 
         ctx.module->setDataLayout(target_machine->createDataLayout());
         ctx.module->setTargetTriple(triple);
 
+        std::vector<Remark> remarks;
+        if (options.remarks) {
+            ctx.context.setDiagnosticHandler(
+                std::make_unique<RemarkCollector>(*options.remarks, ctx.debug_locations, remarks));
+        }
+        std::unique_ptr<llvm::ToolOutputFile> remarks_file;
+        if (options.remarks_output) {
+            auto file = llvm::setupLLVMOptimizationRemarks(ctx.context, *options.remarks_output,
+                                                           options.remarks.value_or(""), "yaml", false);
+            if (!file) {
+                llvm::errs() << llvm::toString(file.takeError()) << '\n';
+                std::exit(1);
+            }
+            remarks_file = std::move(*file);
+        }
+
+        // Check before optimizing, since the passes assume valid IR and would only make a bug harder to find
+        if (llvm::verifyModule(*ctx.module, &llvm::errs())) {
+            llvm::errs() << "Internal error: generated invalid IR\n";
+            std::exit(1);
+        }
+
+        optimize_module(ctx, target_machine, options);
+
         // Create chungbuild directory
         std::string output_filename{"output.o"};
         std::filesystem::create_directory("chungbuild");
@@ -190,17 +310,48 @@ int run_parse(std::vector<std::string>& args) {
         pass.run(*ctx.module);
         dest.flush();
 
-        if (llvm::verifyModule(*ctx.module, &llvm::errs())) {
-            llvm::errs() << "Internal error: generated invalid IR\n";
-            std::exit(1);
+        // In source order, rather than the order the passes ran in. Remarks without a location go last
+        auto position = [](const Remark& remark) {
+            return remark.loc ? std::pair{remark.loc->line, remark.loc->column} : std::pair{SIZE_MAX, SIZE_MAX};
+        };
+        std::stable_sort(remarks.begin(), remarks.end(),
+                         [&](const Remark& a, const Remark& b) { return position(a) < position(b); });
+
+        // Passes that revisit code, like the inliner, can report the same thing more than once
+        auto same_remark = [&](const Remark& a, const Remark& b) {
+            return a.kind == b.kind && a.pass == b.pass && a.message == b.message && position(a) == position(b);
+        };
+        remarks.erase(std::unique(remarks.begin(), remarks.end(), same_remark), remarks.end());
+        for (const auto& remark : remarks) {
+            std::cout << remark.write(source_lines) << '\n';
+        }
+        if (remarks_file) {
+            remarks_file->keep();
         }
 
         // IDK /shrug
         // system("clang++ src/library/prelude.cpp -Iinclude -c -o chungbuild/prelude.o");
         // system((std::string{"clang++ $(llvm-config --ldflags --libs) "} + output_filepath + " chungbuild/prelude.o -o
         // chungbuild/output.out").c_str());
-        system("clang++ src/library/prelude.cpp -Iinclude -c -o chungbuild/prelude.o");      // NOLINT
-        system("clang++ chungbuild/output.o chungbuild/prelude.o -lraylib -o chungbuild/output.out"); // NOLINT
+        // The prelude is built the same way, so perf and debuggers see through it too
+        std::string flags = " -O" + std::to_string(options.opt_level);
+        if (options.debug_info) {
+            flags += " -g";
+        }
+        if (options.frame_pointers) {
+            flags += " -fno-omit-frame-pointer";
+        }
+        std::string prelude_command =
+            "clang++ src/library/prelude.cpp -Iinclude" + flags + " -c -o chungbuild/prelude.o";
+
+        // The instrumented program needs clang's profile runtime, which -fprofile-generate links in
+        if (options.profile_generate) {
+            flags += " -fprofile-generate";
+        }
+        std::string link_command = "clang++ chungbuild/output.o chungbuild/prelude.o -lraylib" + flags +
+                                   " -o chungbuild/output.out";
+        system(prelude_command.c_str()); // NOLINT
+        system(link_command.c_str());    // NOLINT
     }
 
     return 0;
@@ -5,6 +5,30 @@
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/MDBuilder.h>
+
+llvm::Value* codegen_comparison(Context& ctx, ResolvedExpr& condition) {
+    llvm::Value* condition_code = condition.codegen(ctx);
+
+    if (condition.type == Type::boolean) {
+        return condition_code;
+    }
+    return ctx.type_to_bool(condition_code);
+}
+
+// @likely and @unlikely conditions weight the branch 2000:1, like clang does for __builtin_expect
+llvm::BranchInst* codegen_branch(Context& ctx, ResolvedExpr& condition, llvm::BasicBlock* true_block,
+                                 llvm::BasicBlock* false_block) {
+    auto* expect = dynamic_cast<ResolvedExpect*>(&condition);
+    if (!expect) {
+        return ctx.builder.CreateCondBr(codegen_comparison(ctx, condition), true_block, false_block);
+    }
+
+    llvm::MDBuilder md_builder{ctx.context};
+    llvm::MDNode* weights =
+        expect->likely ? md_builder.createBranchWeights(2000, 1) : md_builder.createBranchWeights(1, 2000);
+    return ctx.builder.CreateCondBr(codegen_comparison(ctx, *expect->condition), true_block, false_block, weights);
+}
 
 void codegen_logical_operators(Context& ctx, llvm::BasicBlock* true_block, ResolvedExpr& bin,
                                llvm::BasicBlock* false_block) {
@@ -26,42 +50,429 @@ void codegen_logical_operators(Context& ctx, llvm::BasicBlock* true_block, Resol
         return;
     }
 
-    llvm::Value* value = ctx.type_to_bool(bin.codegen(ctx));
-    ctx.builder.CreateCondBr(value, true_block, false_block);
+    codegen_branch(ctx, bin, true_block, false_block);
 }
 
-llvm::Value* codegen_comparison(Context& ctx, ResolvedExpr& condition) {
-    llvm::Value* condition_code = condition.codegen(ctx);
+// Control already left the current block (return or tail call), so anything after it is emitted into a block that
+// nothing branches to
+llvm::Value* codegen_dead_block(Context& ctx, llvm::Type* type, const char* name) {
+    llvm::Function* current_function = ctx.builder.GetInsertBlock()->getParent();
+    ctx.builder.SetInsertPoint(llvm::BasicBlock::Create(ctx.context, name, current_function));
 
-    if (condition.type == Type::boolean) {
-        return condition_code;
+    if (type->isVoidTy()) {
+        return nullptr;
     }
-    return ctx.type_to_bool(condition_code);
+    return llvm::PoisonValue::get(type);
 }
 
-llvm::Value* ResolvedVarDeclare::codegen(Context& ctx) {
+// Continues in a new block if `ok` holds, otherwise calls the runtime panic function, which reports the error and
+// exits. Panic functions are cold and noreturn, so LLVM moves the failure blocks out of the way
+void codegen_runtime_check(Context& ctx, llvm::Value* ok, const std::string& name, const char* panic_function,
+                           llvm::ArrayRef<llvm::Value*> args) {
+    if (auto* constant = llvm::dyn_cast<llvm::ConstantInt>(ok); constant && constant->isOne()) {
+        return;
+    }
+
     llvm::Function* current_function = ctx.builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* ok_block = llvm::BasicBlock::Create(ctx.context, name + ".ok", current_function);
+    llvm::BasicBlock* fail_block = llvm::BasicBlock::Create(ctx.context, name + ".fail", current_function);
+    ctx.builder.CreateCondBr(ok, ok_block, fail_block);
+
+    ctx.builder.SetInsertPoint(fail_block);
+    ctx.builder.CreateCall(ctx.module->getFunction(panic_function), args);
+    ctx.builder.CreateUnreachable();
+
+    ctx.builder.SetInsertPoint(ok_block);
+}
+
+// Unsigned, so negative indices fail too
+void codegen_bounds_check(Context& ctx, llvm::Value* index, llvm::Value* length, const SourceLocation& loc) {
+    llvm::Value* in_bounds = ctx.builder.CreateICmpULT(index, length, "inbounds");
+    codegen_runtime_check(ctx, in_bounds, "bounds", "panic_index_out_of_bounds",
+                          {index, length, ctx.builder.getInt64(loc.line)});
+}
+
+// Distinct, self-referential loop ID for the latch branch, or nullptr if there's nothing to say about the loop
+llvm::MDNode* codegen_loop_metadata(Context& ctx, const LoopHints& hints, bool must_progress) {
+    std::vector<llvm::Metadata*> operands{nullptr};
+    auto add_property = [&](const char* name, llvm::Constant* value = nullptr) {
+        std::vector<llvm::Metadata*> property{llvm::MDString::get(ctx.context, name)};
+        if (value) {
+            property.push_back(llvm::ConstantAsMetadata::get(value));
+        }
+        operands.push_back(llvm::MDNode::get(ctx.context, property));
+    };
 
-    if (false) { // Is string literal
-        llvm::AllocaInst* var = ctx.allocate_stack_variable(name, ctx.llvm_types.at(type));
+    // Range loops always terminate, so LLVM may delete them outright when nothing uses their results
+    if (must_progress) {
+        add_property("llvm.loop.mustprogress");
+    }
+
+    if (hints.unroll && !*hints.unroll) {
+        add_property("llvm.loop.unroll.disable");
+    } else if (hints.unroll_full) {
+        add_property("llvm.loop.unroll.full");
+    } else if (hints.unroll_count) {
+        add_property("llvm.loop.unroll.count", ctx.builder.getInt32(hints.unroll_count));
+    } else if (hints.unroll) {
+        add_property("llvm.loop.unroll.enable");
+    }
 
-        // auto* str_var = ctx.builder.CreateGEP(Type *Ty, Value *Ptr, ArrayRef<Value *> IdxList)
-        llvm::Value* value = expr->codegen(ctx);
-        auto* cast_value = llvm::dyn_cast<llvm::ConstantStruct>(value);
-        ctx.builder.CreateExtractValue(value, 0);
+    if (hints.vectorize) {
+        add_property("llvm.loop.vectorize.enable", ctx.builder.getInt1(*hints.vectorize));
+    }
+    if (hints.vectorize_width) {
+        add_property("llvm.loop.vectorize.width", ctx.builder.getInt32(hints.vectorize_width));
+    }
+    if (hints.interleave_count) {
+        add_property("llvm.loop.interleave.count", ctx.builder.getInt32(hints.interleave_count));
+    }
+    if (hints.distribute) {
+        add_property("llvm.loop.distribute.enable", ctx.builder.getTrue());
+    }
 
-        ctx.named_values[this] = var;
+    if (operands.size() == 1) {
         return nullptr;
-    } else {
-        llvm::AllocaInst* var = ctx.allocate_stack_variable(name, ctx.llvm_types.at(type));
+    }
+    llvm::MDNode* loop_id = llvm::MDNode::getDistinct(ctx.context, operands);
+    loop_id->replaceOperandWith(0, loop_id);
+    return loop_id;
+}
+
+// Integer division by zero is undefined in LLVM, and so is MIN / -1 for signed integers (the quotient doesn't fit, and
+// x86's idiv traps on it). Both panic instead. Vectors check all of their lanes at once
+void codegen_division_check(Context& ctx, bool is_signed, llvm::Value* lhs, llvm::Value* rhs,
+                            const SourceLocation& loc) {
+    auto any_lane = [&](llvm::Value* condition) {
+        return condition->getType()->isVectorTy() ? ctx.builder.CreateOrReduce(condition) : condition;
+    };
+
+    llvm::Type* type = rhs->getType();
+    llvm::Value* is_zero = any_lane(ctx.builder.CreateICmpEQ(rhs, llvm::Constant::getNullValue(type)));
+    codegen_runtime_check(ctx, ctx.builder.CreateNot(is_zero), "divzero", "panic_division_by_zero",
+                          {ctx.builder.getInt64(loc.line)});
+    if (!is_signed) {
+        return;
+    }
+
+    llvm::Value* min = llvm::ConstantInt::get(type, llvm::APInt::getSignedMinValue(type->getScalarSizeInBits()));
+    llvm::Value* minus_one = llvm::ConstantInt::getSigned(type, -1);
+    llvm::Value* overflows =
+        ctx.builder.CreateAnd(ctx.builder.CreateICmpEQ(lhs, min), ctx.builder.CreateICmpEQ(rhs, minus_one));
+    codegen_runtime_check(ctx, ctx.builder.CreateNot(any_lane(overflows)), "divoverflow", "panic_division_overflow",
+                          {ctx.builder.getInt64(loc.line)});
+}
+
+// Integer +, - and *. Wrapping emits the plain instruction, undefined adds nsw (or nuw for unsigned types) so LLVM can
+// assume the result fits, and trapping uses the *.with.overflow intrinsics to panic when it doesn't
+llvm::Value* codegen_integer_arithmetic(Context& ctx, TokenType op, bool is_signed, OverflowMode overflow,
+                                        llvm::Value* lhs, llvm::Value* rhs, const SourceLocation& loc) {
+    if (overflow != OverflowMode::TRAP) {
+        bool no_wrap = overflow == OverflowMode::UNDEFINED;
+        bool nuw = no_wrap && !is_signed;
+        bool nsw = no_wrap && is_signed;
+        switch (op) {
+            case TokenType::ADD:
+                return ctx.builder.CreateAdd(lhs, rhs, "", nuw, nsw);
+            case TokenType::SUB:
+                return ctx.builder.CreateSub(lhs, rhs, "", nuw, nsw);
+            default:
+                return ctx.builder.CreateMul(lhs, rhs, "", nuw, nsw);
+        }
+    }
+
+    static const std::map<TokenType, std::pair<llvm::Intrinsic::ID, llvm::Intrinsic::ID>> intrinsics{
+        {TokenType::ADD, {llvm::Intrinsic::sadd_with_overflow, llvm::Intrinsic::uadd_with_overflow}},
+        {TokenType::SUB, {llvm::Intrinsic::ssub_with_overflow, llvm::Intrinsic::usub_with_overflow}},
+        {TokenType::MUL, {llvm::Intrinsic::smul_with_overflow, llvm::Intrinsic::umul_with_overflow}}};
+    const auto& [signed_intrinsic, unsigned_intrinsic] = intrinsics.at(op);
+    llvm::Value* result =
+        ctx.builder.CreateBinaryIntrinsic(is_signed ? signed_intrinsic : unsigned_intrinsic, lhs, rhs);
+
+    // Vectors check all of their lanes at once
+    llvm::Value* overflowed = ctx.builder.CreateExtractValue(result, 1);
+    if (overflowed->getType()->isVectorTy()) {
+        overflowed = ctx.builder.CreateOrReduce(overflowed);
+    }
+    codegen_runtime_check(ctx, ctx.builder.CreateNot(overflowed), "overflow", "panic_integer_overflow",
+                          {ctx.builder.getInt64(loc.line)});
+    return ctx.builder.CreateExtractValue(result, 0);
+}
+
+// Exponentiation by squaring, with the multiplications following the overflow mode. Constant exponents are unrolled
+// into the multiplications they need; otherwise it's a loop over the exponent's bits. Vector bases square all of their
+// lanes at once, since the exponent is a scalar
+llvm::Value* codegen_integer_power(Context& ctx, bool is_signed, OverflowMode overflow, llvm::Value* base,
+                                   llvm::Value* exponent, bool exponent_is_signed, const SourceLocation& loc) {
+    auto multiply = [&](llvm::Value* lhs, llvm::Value* rhs) {
+        return codegen_integer_arithmetic(ctx, TokenType::MUL, is_signed, overflow, lhs, rhs, loc);
+    };
+    llvm::Value* one = llvm::ConstantInt::get(base->getType(), 1);
+
+    auto* constant = llvm::dyn_cast<llvm::ConstantInt>(exponent);
+    if (constant && !(exponent_is_signed && constant->isNegative())) {
+        llvm::Value* result = nullptr;
+        llvm::Value* power = base;
+        for (llvm::APInt remaining = constant->getValue(); !remaining.isZero(); remaining.lshrInPlace(1)) {
+            if (remaining[0]) {
+                result = result ? multiply(result, power) : power;
+            }
+            if (remaining.ugt(1)) {
+                power = multiply(power, power);
+            }
+        }
+        return result ? result : one;
+    }
+
+    if (exponent_is_signed) {
+        llvm::Value* non_negative =
+            ctx.builder.CreateICmpSGE(exponent, llvm::Constant::getNullValue(exponent->getType()), "exponent.valid");
+        codegen_runtime_check(ctx, non_negative, "exponent", "panic_negative_exponent",
+                              {ctx.builder.CreateSExt(exponent, ctx.builder.getInt64Ty()),
+                               ctx.builder.getInt64(loc.line)});
+    }
+
+    llvm::Function* current_function = ctx.builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* entry = ctx.builder.GetInsertBlock();
+    auto* loop = llvm::BasicBlock::Create(ctx.context, "pow.loop", current_function);
+    auto* odd_block = llvm::BasicBlock::Create(ctx.context, "pow.odd", current_function);
+    auto* next = llvm::BasicBlock::Create(ctx.context, "pow.next", current_function);
+    auto* square = llvm::BasicBlock::Create(ctx.context, "pow.square", current_function);
+    auto* done = llvm::BasicBlock::Create(ctx.context, "pow.done", current_function);
+    ctx.builder.CreateBr(loop);
+
+    // result * power ** remaining stays equal to base ** exponent
+    ctx.builder.SetInsertPoint(loop);
+    llvm::PHINode* result = ctx.builder.CreatePHI(base->getType(), 2, "pow.result");
+    llvm::PHINode* power = ctx.builder.CreatePHI(base->getType(), 2, "pow.power");
+    llvm::PHINode* remaining = ctx.builder.CreatePHI(exponent->getType(), 2, "pow.remaining");
+    result->addIncoming(one, entry);
+    power->addIncoming(base, entry);
+    remaining->addIncoming(exponent, entry);
+    llvm::Value* odd = ctx.builder.CreateTrunc(remaining, ctx.builder.getInt1Ty(), "pow.isodd");
+    ctx.builder.CreateCondBr(odd, odd_block, next);
+
+    ctx.builder.SetInsertPoint(odd_block);
+    llvm::Value* product = multiply(result, power);
+    llvm::BasicBlock* product_block = ctx.builder.GetInsertBlock();
+    ctx.builder.CreateBr(next);
+
+    // The last bit is done before squaring, which could overflow even though the result doesn't
+    ctx.builder.SetInsertPoint(next);
+    llvm::PHINode* next_result = ctx.builder.CreatePHI(base->getType(), 2, "pow.next.result");
+    next_result->addIncoming(result, loop);
+    next_result->addIncoming(product, product_block);
+    llvm::Value* next_remaining = ctx.builder.CreateLShr(remaining, 1);
+    llvm::Value* finished = ctx.builder.CreateICmpEQ(next_remaining, llvm::Constant::getNullValue(exponent->getType()));
+    ctx.builder.CreateCondBr(finished, done, square);
+
+    ctx.builder.SetInsertPoint(square);
+    llvm::Value* next_power = multiply(power, power);
+    result->addIncoming(next_result, ctx.builder.GetInsertBlock());
+    power->addIncoming(next_power, ctx.builder.GetInsertBlock());
+    remaining->addIncoming(next_remaining, ctx.builder.GetInsertBlock());
+    ctx.builder.CreateBr(loop);
+
+    ctx.builder.SetInsertPoint(done);
+    return next_result;
+}
+
+// Float bases use llvm.powi for exponents that fit its i32 and llvm.pow otherwise
+llvm::Value* codegen_power(Context& ctx, const Type& base_type, const Type& exponent_type, OverflowMode overflow,
+                           llvm::Value* base, llvm::Value* exponent, const SourceLocation& loc) {
+    const Type& scalar_type = base_type.is_vector() ? *base_type.element : base_type;
+    if (scalar_type.is_integer()) {
+        return codegen_integer_power(ctx, scalar_type.is_signed_integer(), overflow, base, exponent,
+                                     exponent_type.is_signed_integer(), loc);
+    }
+    if (exponent_type.is_float()) {
+        return ctx.builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, base, exponent);
+    }
+
+    if (exponent_type == Type::int32) {
+        return ctx.builder.CreateIntrinsic(llvm::Intrinsic::powi, {base->getType(), exponent->getType()},
+                                           {base, exponent});
+    }
+    llvm::Type* float_type = ctx.get_llvm_type(scalar_type);
+    llvm::Value* float_exponent = exponent_type.is_signed_integer() ? ctx.builder.CreateSIToFP(exponent, float_type)
+                                                                    : ctx.builder.CreateUIToFP(exponent, float_type);
+    if (base_type.is_vector()) {
+        float_exponent = ctx.builder.CreateVectorSplat(base_type.length, float_exponent);
+    }
+    return ctx.builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, base, float_exponent);
+}
+
+// Vectors are lowered lane by lane, i.e. exactly like their element type
+llvm::Value* codegen_binary_op(Context& ctx, TokenType op, const Type& type, OverflowMode overflow,
+                               llvm::Value* lhs_code, llvm::Value* rhs_code, const SourceLocation& loc) {
+    const Type& scalar_type = type.is_vector() ? *type.element : type;
+    switch (op) {
+        // TODO: Add type system (wow)
+        case TokenType::ADD:
+            if (scalar_type.is_integer()) {
+                return codegen_integer_arithmetic(ctx, op, scalar_type.is_signed_integer(), overflow, lhs_code,
+                                                  rhs_code, loc);
+            } else if (scalar_type == Type::boolean) {
+                return ctx.builder.CreateAdd(lhs_code, rhs_code);
+            } else if (scalar_type.is_float()) {
+                return ctx.builder.CreateFAdd(lhs_code, rhs_code);
+            }
+            break;
+        case TokenType::SUB:
+            if (scalar_type.is_integer()) {
+                return codegen_integer_arithmetic(ctx, op, scalar_type.is_signed_integer(), overflow, lhs_code,
+                                                  rhs_code, loc);
+            } else if (scalar_type == Type::boolean) {
+                return ctx.builder.CreateSub(lhs_code, rhs_code);
+            } else if (scalar_type.is_float()) {
+                return ctx.builder.CreateFSub(lhs_code, rhs_code);
+            }
+            break;
+        case TokenType::MUL:
+            if (scalar_type.is_integer()) {
+                return codegen_integer_arithmetic(ctx, op, scalar_type.is_signed_integer(), overflow, lhs_code,
+                                                  rhs_code, loc);
+            } else if (scalar_type == Type::boolean) {
+                return ctx.builder.CreateMul(lhs_code, rhs_code);
+            } else if (scalar_type.is_float()) {
+                return ctx.builder.CreateFMul(lhs_code, rhs_code);
+            }
+            break;
+        case TokenType::DIV:
+        case TokenType::MOD: {
+            bool is_div = op == TokenType::DIV;
+            if (scalar_type.is_float()) {
+                return is_div ? ctx.builder.CreateFDiv(lhs_code, rhs_code) : ctx.builder.CreateFRem(lhs_code, rhs_code);
+            } else if (!scalar_type.is_integer()) {
+                break;
+            }
+
+            // Rounds towards zero, and the remainder takes the sign of the dividend, like C
+            bool is_signed = scalar_type.is_signed_integer();
+            codegen_division_check(ctx, is_signed, lhs_code, rhs_code, loc);
+            if (is_signed) {
+                return is_div ? ctx.builder.CreateSDiv(lhs_code, rhs_code) : ctx.builder.CreateSRem(lhs_code, rhs_code);
+            }
+            return is_div ? ctx.builder.CreateUDiv(lhs_code, rhs_code) : ctx.builder.CreateURem(lhs_code, rhs_code);
+        }
+        case TokenType::BITWISE_AND:
+            return ctx.builder.CreateAnd(lhs_code, rhs_code);
+        case TokenType::BITWISE_OR:
+            return ctx.builder.CreateOr(lhs_code, rhs_code);
+        case TokenType::BITWISE_XOR:
+            return ctx.builder.CreateXor(lhs_code, rhs_code);
+        case TokenType::SHIFT_LEFT:
+        case TokenType::SHIFT_RIGHT: {
+            // The amount wraps around the bit width (x << 65 is x << 1 for an int64) rather than being poison. x86 and
+            // ARM shift instructions mask their amount anyway, so for 32 and 64 bit types this usually folds away
+            unsigned bit_width = scalar_type.bit_width();
+            llvm::Value* amount =
+                ctx.builder.CreateAnd(rhs_code, llvm::ConstantInt::get(rhs_code->getType(), bit_width - 1));
+            if (op == TokenType::SHIFT_LEFT) {
+                return ctx.builder.CreateShl(lhs_code, amount);
+            }
+            // Signed values shift in copies of the sign bit, unsigned ones zeros
+            if (scalar_type.is_signed_integer()) {
+                return ctx.builder.CreateAShr(lhs_code, amount);
+            }
+            return ctx.builder.CreateLShr(lhs_code, amount);
+        }
+        case TokenType::GREATER_THAN:
+            if (scalar_type.is_signed_integer()) {
+                return ctx.builder.CreateICmpSGT(
+                    lhs_code, rhs_code); // TODO: ICmpSGT Is only for I-nteger Cmp-arison with S-igned G-reater T-han
+            } else if (scalar_type.is_unsigned_integer()) {
+                return ctx.builder.CreateICmpUGT(lhs_code, rhs_code);
+            } else if (scalar_type.is_float()) {
+                return ctx.builder.CreateFCmpOGT(lhs_code, rhs_code);
+            }
+            break;
+        case TokenType::LESS_THAN:
+            if (scalar_type.is_signed_integer()) {
+                return ctx.builder.CreateICmpSLT(
+                    lhs_code, rhs_code); // TODO: ICmpSGT Is only for I-nteger Cmp-arison with S-igned L-ess T-han
+            } else if (scalar_type.is_unsigned_integer()) {
+                return ctx.builder.CreateICmpULT(lhs_code, rhs_code);
+            } else if (scalar_type.is_float()) {
+                return ctx.builder.CreateFCmpOLT(lhs_code, rhs_code);
+            }
+            break;
+        case TokenType::GREATER_EQUAL:
+            if (scalar_type.is_signed_integer()) {
+                return ctx.builder.CreateICmpSGE(lhs_code, rhs_code);
+            } else if (scalar_type.is_unsigned_integer()) {
+                return ctx.builder.CreateICmpUGE(lhs_code, rhs_code);
+            } else if (scalar_type.is_float()) {
+                return ctx.builder.CreateFCmpOGE(lhs_code, rhs_code);
+            }
+            break;
+        case TokenType::LESS_EQUAL:
+            if (scalar_type.is_signed_integer()) {
+                return ctx.builder.CreateICmpSLE(lhs_code, rhs_code);
+            } else if (scalar_type.is_unsigned_integer()) {
+                return ctx.builder.CreateICmpULE(lhs_code, rhs_code);
+            } else if (scalar_type.is_float()) {
+                return ctx.builder.CreateFCmpOLE(lhs_code, rhs_code);
+            }
+            break;
+        case TokenType::EQUAL:
+            if (scalar_type.is_float()) {
+                return ctx.builder.CreateFCmpOEQ(lhs_code, rhs_code);
+            }
+            return ctx.builder.CreateICmpEQ(lhs_code, rhs_code);
+        case TokenType::NOT_EQUAL:
+            // NaN != NaN
+            if (scalar_type.is_float()) {
+                return ctx.builder.CreateFCmpUNE(lhs_code, rhs_code);
+            }
+            return ctx.builder.CreateICmpNE(lhs_code, rhs_code);
+        default:
+            break;
+    }
+
+    std::cerr << "NOT IMPLEMENTED YET (BinaryExprAST)\n";
+    return nullptr;
+}
+
+// Arrays are values, so binding or assigning one copies the elements into storage of its own and writes through one
+// name never show up in another. Fresh array literals already own their storage. Slices are views and aren't copied
+llvm::Value* codegen_array_copy(Context& ctx, const Type& type, const ResolvedExpr& expr, llvm::Value* array) {
+    if (!array || type.ty != Ty::ARRAY || dynamic_cast<const ResolvedArrayLiteral*>(&expr)) {
+        return array;
+    }
+
+    llvm::Type* storage_type = llvm::ArrayType::get(ctx.get_llvm_type(*type.element), type.length);
+    llvm::AllocaInst* storage = ctx.allocate_stack_variable("array.copy", storage_type);
+    ctx.builder.CreateMemCpy(storage, storage->getAlign(), ctx.builder.CreateExtractValue(array, 0),
+                             storage->getAlign(), llvm::ConstantExpr::getSizeOf(storage_type));
+    return ctx.builder.CreateInsertValue(array, storage, 0);
+}
+
+llvm::Value* ResolvedVarDeclare::codegen(Context& ctx) {
+    llvm::Type* llvm_type = ctx.get_llvm_type(type);
+
+    // Variables without an initializer start out zeroed rather than undef, so e.g. a string is {null, 0} and can be
+    // passed to the runtime's noundef string parameters
+    llvm::Value* value = expr ? codegen_array_copy(ctx, type, *expr, expr->codegen(ctx))
+                              : llvm::Constant::getNullValue(llvm_type);
 
-        if (expr) {
-            ctx.builder.CreateStore(expr->codegen(ctx), var);
+    // Immutable bindings can never be stored to again, so they bind straight to their SSA value
+    if (!is_mutable) {
+        if (value && llvm::isa<llvm::Instruction>(value) && !value->hasName()) {
+            value->setName(name);
         }
 
-        ctx.named_values[this] = var;
+        ctx.named_values[slot] = value;
+        ctx.declare_debug_variable(name, type, value, false, loc);
         return nullptr;
     }
+
+    llvm::AllocaInst* var = ctx.allocate_stack_variable(name, llvm_type);
+    ctx.builder.CreateStore(value, var);
+
+    ctx.named_values[slot] = var;
+    ctx.declare_debug_variable(name, type, var, true, loc);
+    return nullptr;
 }
 
 llvm::Value* ResolvedParamDeclare::codegen(Context& /*ctx*/) {
@@ -72,63 +483,154 @@ llvm::Value* ResolvedParamDeclare::codegen(Context& /*ctx*/) {
 
 llvm::Value* ResolvedBlock::codegen(Context& ctx, bool create_ret_instructions) {
     for (auto& stmt : body) {
+        ctx.set_debug_location(stmt->loc);
         stmt->codegen(ctx);
     }
 
     // TODO: FLAWED: MUST MOVE THIS OUTSIDE SO THAT BLOCKS WITH RETURN VALUES CAN DO SOMETHING OTHER THAN RETURN
     llvm::Value* return_expr = nullptr;
     if (return_value) {
+        ctx.set_debug_location(return_value->loc);
         return_expr = return_value->codegen(ctx);
-        if (create_ret_instructions) {
+        if (create_ret_instructions && return_value->type != Type::void_) {
             ctx.builder.CreateRet(return_expr);
         }
     }
     return return_expr;
 }
 
-llvm::Value* ResolvedFunction::codegen(Context& ctx) {
-    if (name == "print") { // Nah no need
-        return nullptr;
+llvm::Function* ResolvedFunction::declare(Context& ctx) {
+    // Builtins are declared by setup_prelude; just bind to them
+    if (is_builtin) {
+        llvm_function = ctx.module->getFunction(name);
+        return llvm_function;
     }
 
     std::vector<llvm::Type*> parameter_types;
     parameter_types.reserve(parameters.size());
     for (auto& parameter : parameters) {
-        parameter_types.push_back(ctx.llvm_types.at(parameter->type));
+        parameter_types.push_back(ctx.get_llvm_type(parameter->type));
     }
 
-    llvm::FunctionType* function_type = llvm::FunctionType::get(ctx.llvm_types.at(type), parameter_types, false);
-    llvm::Function* function =
-        llvm::Function::Create(function_type, llvm::Function::ExternalLinkage, name, ctx.module.get());
+    llvm::FunctionType* function_type = llvm::FunctionType::get(ctx.get_llvm_type(type), parameter_types, false);
+
+    // Only functions visible outside the module need a stable ABI; the rest are fair game for IPO and fastcc
+    auto linkage = is_exported ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage;
+    llvm::Function* function = llvm::Function::Create(function_type, linkage, name, ctx.module.get());
+    function->setCallingConv(is_exported ? llvm::CallingConv::C : llvm::CallingConv::Fast);
 
+    // Chung has no exceptions, so nothing unwinds; everything else comes from Sema::infer_effects
+    function->setDoesNotThrow();
+    if (!effects.accesses_memory && effects.accesses_runtime_state) {
+        function->setOnlyAccessesInaccessibleMemory();
+    } else if (!effects.accesses_memory) {
+        function->setDoesNotAccessMemory();
+    }
+    if (!effects.synchronizes) {
+        function->addFnAttr(llvm::Attribute::NoSync);
+    }
+    if (effects.will_return) {
+        function->addFnAttr(llvm::Attribute::WillReturn);
+    }
+
+    // Like clang, cold functions are also optimized for size
+    if (is_hot) {
+        function->addFnAttr(llvm::Attribute::Hot);
+    }
+    if (is_cold) {
+        function->addFnAttr(llvm::Attribute::Cold);
+        function->addFnAttr(llvm::Attribute::OptimizeForSize);
+    }
+
+    // The instructions carry their own fast math flags, but some backend combines still only look at these
+    if (float_model.fast_math) {
+        for (const char* attribute : {"unsafe-fp-math", "no-nans-fp-math", "no-infs-fp-math",
+                                      "no-signed-zeros-fp-math", "approx-func-fp-math"}) {
+            function->addFnAttr(attribute, "true");
+        }
+    }
+
+    llvm_function = function;
+    return function;
+}
+
+llvm::Value* ResolvedFunction::codegen(Context& ctx) {
+    if (is_builtin) {
+        return nullptr;
+    }
+
+    llvm::Function* function = llvm_function;
     llvm::BasicBlock* function_block = llvm::BasicBlock::Create(ctx.context, "entry", function);
     ctx.builder.SetInsertPoint(function_block);
+    std::vector<Type> signature{type};
+    for (auto& parameter : parameters) {
+        signature.push_back(parameter->type);
+    }
+    ctx.create_debug_function(function, loc, signature);
+    ctx.set_debug_location(loc);
 
     // Variable insert point so that declarations can get put to the function entry block
     llvm::Value* undef = llvm::UndefValue::get(ctx.builder.getInt32Ty());
     ctx.variable_insert_point = new llvm::BitCastInst(undef, undef->getType(), "alloca.placeholder", function_block);
 
-    ctx.named_values.clear();
+    ctx.named_values.assign(num_slots, nullptr);
+
+    // Every float operation in the body picks these up from the builder. Fast math includes contraction
+    llvm::FastMathFlags flags;
+    if (float_model.fast_math) {
+        flags.setFast();
+    } else if (float_model.contract == FpContract::FAST) {
+        flags.setAllowContract();
+    }
+    ctx.builder.setFastMathFlags(flags);
+    ctx.fp_contract = float_model.contract;
+
+    // Self tail calls branch back to this block, where each parameter becomes a PHI of its incoming arguments
+    ctx.tail_recursion_block = nullptr;
+    if (is_tail_recursive) {
+        ctx.tail_recursion_block = llvm::BasicBlock::Create(ctx.context, "tailrecurse", function);
+        ctx.builder.CreateBr(ctx.tail_recursion_block);
+        ctx.builder.SetInsertPoint(ctx.tail_recursion_block);
+    }
 
     // Set parameter names
     size_t i = 0;
     for (auto& function_parameter : function->args()) {
         auto& parameter_name = parameters[i]->name;
         function_parameter.setName(parameter_name);
-        ctx.named_values[parameters[i].get()] = &function_parameter;
+
+        if (ctx.tail_recursion_block) {
+            llvm::PHINode* phi = ctx.builder.CreatePHI(function_parameter.getType(), 2, parameter_name);
+            phi->addIncoming(&function_parameter, function_block);
+            ctx.named_values[parameters[i]->slot] = phi;
+        } else {
+            ctx.named_values[parameters[i]->slot] = &function_parameter;
+        }
 
         i++;
     }
+    // After all the parameters, since the PHIs have to stay at the top of the block
+    for (i = 0; i < parameters.size(); i++) {
+        ctx.declare_debug_variable(parameters[i]->name, parameters[i]->type, ctx.named_values[parameters[i]->slot],
+                                   false, parameters[i]->loc, i + 1);
+    }
     body->codegen(ctx, true);
 
     // Void FOR NOW
-    if (type.ty == Ty::VOID) {
-        ctx.builder.CreateRet(nullptr);
+    if (!ctx.builder.GetInsertBlock()->getTerminator()) {
+        if (type.ty == Ty::VOID) {
+            ctx.builder.CreateRet(nullptr);
+        } else {
+            // Only reachable after an explicit return
+            ctx.builder.CreateUnreachable();
+        }
     }
     llvm::verifyFunction(*function);
 
     ctx.variable_insert_point->eraseFromParent();
     ctx.variable_insert_point = nullptr;
+    ctx.tail_recursion_block = nullptr;
+    ctx.builder.SetCurrentDebugLocation(llvm::DebugLoc{});
 
     return nullptr;
 }
@@ -144,14 +646,16 @@ llvm::Value* ResolvedIfExpr::codegen(Context& ctx) {
         else_block = llvm::BasicBlock::Create(ctx.context, "if.else");
     }
 
-    llvm::Value* boolean = codegen_comparison(ctx, *condition);
-    ctx.builder.CreateCondBr(boolean, if_block, else_block);
+    codegen_branch(ctx, *condition, if_block, else_block);
 
     if_block->insertInto(current_function);
     ctx.builder.SetInsertPoint(if_block);
     llvm::Value* body_value = body->codegen(ctx, false);
     ctx.builder.CreateBr(cont_block);
 
+    // Same as the else block below, the body may have ended in a different block than it started in
+    if_block = ctx.builder.GetInsertBlock();
+
     llvm::Value* else_value = nullptr;
 
     if (else_body) {
@@ -166,10 +670,11 @@ llvm::Value* ResolvedIfExpr::codegen(Context& ctx) {
 
     cont_block->insertInto(current_function);
     ctx.builder.SetInsertPoint(cont_block);
+    ctx.set_debug_location(loc);
 
     // If if-exprs actually return something, add a PHI node
     if (type != Type::void_) {
-        llvm::PHINode* node = ctx.builder.CreatePHI(ctx.llvm_types.at(type), 2, "if.tmp");
+        llvm::PHINode* node = ctx.builder.CreatePHI(ctx.get_llvm_type(type), 2, "if.tmp");
         node->addIncoming(body_value, if_block);
         node->addIncoming(else_value, else_block);
         return node;
@@ -192,15 +697,22 @@ llvm::Value* ResolvedUnaryExpr::codegen(Context& ctx) {
     if (!expr_code) {
         return nullptr;
     }
+    ctx.set_debug_location(loc);
 
+    const Type& scalar_type = type.is_vector() ? *type.element : type;
     if (op == TokenType::SUB) {
-        if (type == Type::int64) {
-            return ctx.builder.CreateNeg(expr_code);
-        } else if (type == Type::float64) {
+        if (scalar_type.is_integer()) {
+            llvm::Value* zero = llvm::Constant::getNullValue(expr_code->getType());
+            return codegen_integer_arithmetic(ctx, op, true, overflow, zero, expr_code, loc);
+        } else if (scalar_type.is_float()) {
             return ctx.builder.CreateFNeg(expr_code);
         }
     } else if (op == TokenType::NOT) {
-        if (type == Type::boolean) {
+        if (scalar_type == Type::boolean) {
+            return ctx.builder.CreateNot(expr_code);
+        }
+    } else if (op == TokenType::BITWISE_NOT) {
+        if (scalar_type.is_integer()) {
             return ctx.builder.CreateNot(expr_code);
         }
     }
@@ -209,7 +721,50 @@ llvm::Value* ResolvedUnaryExpr::codegen(Context& ctx) {
     return nullptr;
 }
 
+static const ResolvedBinaryExpr* as_product(const ResolvedExpr& expr) {
+    const auto* binary_expr = dynamic_cast<const ResolvedBinaryExpr*>(&expr);
+    return binary_expr && binary_expr->op == TokenType::MUL ? binary_expr : nullptr;
+}
+
+// a * b + c within one expression, for fp-contract=on. llvm.fmuladd becomes an fma where the target has a fast one, and
+// a multiply and an add elsewhere. Operands are still generated in source order
+llvm::Value* codegen_multiply_add(Context& ctx, const ResolvedBinaryExpr& sum) {
+    const ResolvedBinaryExpr* product = as_product(*sum.lhs);
+    bool product_first = product != nullptr;
+    if (!product_first) {
+        product = as_product(*sum.rhs);
+    }
+
+    llvm::Value* addend = product_first ? nullptr : sum.lhs->codegen(ctx);
+    llvm::Value* multiplier = product->lhs->codegen(ctx);
+    llvm::Value* multiplicand = product->rhs->codegen(ctx);
+    if (product_first) {
+        addend = sum.rhs->codegen(ctx);
+    }
+    if (!addend || !multiplier || !multiplicand) {
+        return nullptr;
+    }
+    ctx.set_debug_location(sum.loc);
+
+    // a * b - c is a * b + -c, and c - a * b is -a * b + c
+    if (sum.op == TokenType::SUB) {
+        if (product_first) {
+            addend = ctx.builder.CreateFNeg(addend);
+        } else {
+            multiplier = ctx.builder.CreateFNeg(multiplier);
+        }
+    }
+    return ctx.builder.CreateIntrinsic(llvm::Intrinsic::fmuladd, {addend->getType()},
+                                       {multiplier, multiplicand, addend});
+}
+
 llvm::Value* ResolvedBinaryExpr::codegen(Context& ctx) {
+    const Type& scalar_type = type.is_vector() ? *type.element : type;
+    if (ctx.fp_contract == FpContract::ON && scalar_type.is_float() &&
+        (op == TokenType::ADD || op == TokenType::SUB) && (as_product(*lhs) || as_product(*rhs))) {
+        return codegen_multiply_add(ctx, *this);
+    }
+
     llvm::Value* lhs_code = nullptr;
     llvm::Value* rhs_code = nullptr;
 
@@ -220,48 +775,9 @@ llvm::Value* ResolvedBinaryExpr::codegen(Context& ctx) {
             return nullptr;
         }
     }
+    ctx.set_debug_location(loc);
 
     switch (op) {
-        // TODO: Add type system (wow)
-        case TokenType::ADD:
-            if (type == Type::int64 || type == Type::boolean) {
-                return ctx.builder.CreateAdd(lhs_code, rhs_code);
-            } else if (type == Type::float64) {
-                return ctx.builder.CreateFAdd(lhs_code, rhs_code);
-            }
-            break;
-        case TokenType::SUB:
-            if (type == Type::int64 || type == Type::boolean) {
-                return ctx.builder.CreateSub(lhs_code, rhs_code);
-            } else if (type == Type::float64) {
-                return ctx.builder.CreateFSub(lhs_code, rhs_code);
-            }
-            break;
-        case TokenType::MUL:
-            if (type == Type::int64 || type == Type::boolean) {
-                return ctx.builder.CreateMul(lhs_code, rhs_code);
-            } else if (type == Type::float64) {
-                return ctx.builder.CreateFMul(lhs_code, rhs_code);
-            }
-            break;
-        case TokenType::GREATER_THAN:
-            if (lhs->type == Type::int64) {
-                return ctx.builder.CreateICmpSGT(
-                    lhs_code, rhs_code); // TODO: ICmpSGT Is only for I-nteger Cmp-arison with S-igned G-reater T-han
-            } else if (lhs->type == Type::float64) {
-                return ctx.builder.CreateFCmpUGT(lhs_code, rhs_code);
-            }
-            break;
-        case TokenType::LESS_THAN:
-            if (lhs->type == Type::int64) {
-                return ctx.builder.CreateICmpSLT(
-                    lhs_code, rhs_code); // TODO: ICmpSGT Is only for I-nteger Cmp-arison with S-igned L-ess T-han
-            } else if (lhs->type == Type::float64) {
-                return ctx.builder.CreateFCmpULT(lhs_code, rhs_code);
-            }
-            break;
-        case TokenType::EQUAL:
-            return ctx.builder.CreateICmpEQ(lhs_code, rhs_code);
         case TokenType::AND:
         case TokenType::OR: {
             llvm::Function* current_function = ctx.builder.GetInsertBlock()->getParent();
@@ -294,82 +810,115 @@ llvm::Value* ResolvedBinaryExpr::codegen(Context& ctx) {
 
             return ctx.type_to_bool(phi);
         }
+        case TokenType::POW:
+            return codegen_power(ctx, type, rhs->type, overflow, lhs_code, rhs_code, loc);
         default:
-            std::cerr << "NOT IMPLEMENTED YET (BinaryExprAST)\n";
+            // Operands have the same type; for comparisons that's not the result type
+            return codegen_binary_op(ctx, op, lhs->type, overflow, lhs_code, rhs_code, loc);
     }
-    return nullptr;
+}
+
+llvm::Value* ResolvedExpect::codegen(Context& ctx) {
+    llvm::Value* value = condition->codegen(ctx);
+    if (!value) {
+        return nullptr;
+    }
+    return ctx.builder.CreateIntrinsic(llvm::Intrinsic::expect, {value->getType()},
+                                       {value, ctx.builder.getInt1(likely)});
+}
+
+llvm::Value* ResolvedCast::codegen(Context& ctx) {
+    llvm::Value* value = expr->codegen(ctx);
+    if (!value) {
+        return nullptr;
+    }
+
+    const Type& from = expr->type.is_vector() ? *expr->type.element : expr->type;
+    const Type& to = type.is_vector() ? *type.element : type;
+    llvm::Type* llvm_type = ctx.get_llvm_type(type);
+    if (from.is_float() && to.is_integer()) {
+        // Saturates (and NaN becomes 0), where a plain fptosi would be poison for out of range values
+        llvm::Intrinsic::ID id = to.is_signed_integer() ? llvm::Intrinsic::fptosi_sat : llvm::Intrinsic::fptoui_sat;
+        return ctx.builder.CreateIntrinsic(id, {llvm_type, value->getType()}, {value});
+    }
+
+    // Everything else is a plain sext/zext/trunc, [su]itofp or fpext/fptrunc
+    llvm::Instruction::CastOps opcode =
+        llvm::CastInst::getCastOpcode(value, from.is_signed_integer(), llvm_type, to.is_signed_integer());
+    return ctx.builder.CreateCast(opcode, value, llvm_type);
 }
 
 llvm::Value* ResolvedCall::codegen(Context& ctx) {
-    llvm::Function* function = ctx.module->getFunction(callee->name);
+    llvm::Function* function = callee->llvm_function;
     if (!function) {
         std::cout << "No function named '" + callee->name + "'\n";
         return nullptr;
     }
 
     std::vector<llvm::Value*> argument_values;
-    bool is_c_builtin = std::find(ctx.c_builtins.begin(), ctx.c_builtins.end(), callee->name) != ctx.c_builtins.end();
     for (auto&& arg : arguments) {
         llvm::Value* value = arg->codegen(ctx);
-        if (is_c_builtin && value->getType()->isStructTy()) {
-            value->print(llvm::outs());
-            if (auto* var_arg = dynamic_cast<ResolvedVariable*>(arg.get())) {
-                value = ctx.named_values[var_arg->declaration];
-            } else {
-                auto* struct_type = llvm::dyn_cast<llvm::StructType>(value->getType());
-                llvm::Value* tmp_alloca = ctx.allocate_stack_variable("", value->getType());
-                llvm::outs() << "apsihgjdsdhg";
-            }
+        if (!value) {
+            return nullptr;
+        }
+
+        // The runtime takes strings as separate (pointer, length) arguments so they stay in registers. See
+        // setup_function
+        if (callee->is_builtin && arg->type.ty == Ty::STRING) {
+            argument_values.emplace_back(ctx.builder.CreateExtractValue(value, 0));
+            argument_values.emplace_back(ctx.builder.CreateExtractValue(value, 1));
+            continue;
         }
         argument_values.emplace_back(value);
-        if (!argument_values.back()) {
-            return nullptr;
+    }
+    ctx.set_debug_location(loc);
+
+    llvm::Function* current_function = ctx.builder.GetInsertBlock()->getParent();
+    if (is_tail_call && function == current_function && ctx.tail_recursion_block) {
+        // Rebind the parameters to the new arguments and jump back to the top instead of growing the stack
+        size_t i = 0;
+        for (auto& parameter : callee->parameters) {
+            auto* phi = llvm::cast<llvm::PHINode>(ctx.named_values[parameter->slot]);
+            phi->addIncoming(argument_values[i], ctx.builder.GetInsertBlock());
+            i++;
         }
+        ctx.builder.CreateBr(ctx.tail_recursion_block);
+
+        return codegen_dead_block(ctx, function->getReturnType(), "tailcall.dead");
+    }
+
+    llvm::CallInst* call = ctx.builder.CreateCall(function, argument_values);
+    call->setCallingConv(function->getCallingConv());
+    if (!is_tail_call) {
+        return call;
     }
 
-    return ctx.builder.CreateCall(function, argument_values);
+    // musttail requires identical prototypes and calling conventions; otherwise it's only a hint
+    if (function->getFunctionType() != current_function->getFunctionType() ||
+        function->getCallingConv() != current_function->getCallingConv()) {
+        call->setTailCallKind(llvm::CallInst::TCK_Tail);
+        return call;
+    }
+
+    call->setTailCallKind(llvm::CallInst::TCK_MustTail);
+    ctx.builder.CreateRet(function->getReturnType()->isVoidTy() ? nullptr : call);
+    return codegen_dead_block(ctx, function->getReturnType(), "tailcall.dead");
 }
 
 llvm::Value* ResolvedPrimitive::codegen(Context& ctx) {
+    // Sema already checked that the value fits the type
+    if (type.is_integer()) {
+        return llvm::ConstantInt::get(ctx.get_llvm_type(type), uint64, type.is_signed_integer());
+    }
+    if (type.is_float()) {
+        return llvm::ConstantFP::get(ctx.get_llvm_type(type), float64);
+    }
+
     switch (type.ty) {
-        case Ty::INT64:
-            // std::cout << "Int\n";
-            return llvm::ConstantInt::get(ctx.context, llvm::APInt{64, static_cast<uint64_t>(int64), true});
-        case Ty::UINT64:
-            // std::cout << "Uint\n";
-            return llvm::ConstantInt::get(ctx.context, llvm::APInt{64, uint64, false});
-        case Ty::FLOAT64:
-            // std::cout << "Float\n";
-            return llvm::ConstantFP::get(ctx.context, llvm::APFloat{float64});
         case Ty::BOOL:
             return ctx.builder.getInt1(boolean);
-        case Ty::STRING: {
-            auto* constant = llvm::ConstantDataArray::getString(ctx.context, string, false);
-            auto* array_type = llvm::ArrayType::get(llvm::Type::getInt8Ty(ctx.context), string.length());
-
-            auto* str_global = new llvm::GlobalVariable(*ctx.module, array_type, true,
-                                                        llvm::GlobalValue::PrivateLinkage, constant, "");
-            str_global->setAlignment(llvm::Align(1));
-            str_global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
-
-            // auto* str_pointer = ctx.builder.CreateBitCast(constant, llvm::PointerType::get(ctx.context, 0));
-            auto* zero = llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx.context), 0);
-            auto* str_pointer = ctx.builder.CreateInBoundsGEP(str_global->getType(), constant, {zero, zero}, "str.ptr");
-
-            auto* struct_type = llvm::StructType::get(
-                ctx.context, {llvm::PointerType::get(ctx.context, 0), llvm::Type::getInt64Ty(ctx.context)});
-
-            auto* len_field = llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx.context), string.length());
-            llvm::Value* fat_pointer = llvm::UndefValue::get(struct_type);
-            // auto* ptrField = ctx.builder.CreateStructGEP(struct_type, fat_pointer, 0);
-            // ctx.builder.CreateStore(str_global, ptrField);
-            //
-            // auto* lenField = ctx.builder.CreateStructGEP(struct_type, fat_pointer, 1);
-            // ctx.builder.CreateStore(len_field, lenField);
-            fat_pointer = ctx.builder.CreateInsertValue(fat_pointer, str_global, 0);
-            fat_pointer = ctx.builder.CreateInsertValue(fat_pointer, len_field, 1);
-            return fat_pointer;
-        }
+        case Ty::STRING:
+            return ctx.get_string_literal(string);
         default:
             // std::cout << "L\n";
             return nullptr;
@@ -377,14 +926,16 @@ llvm::Value* ResolvedPrimitive::codegen(Context& ctx) {
 }
 
 llvm::Value* ResolvedVariable::codegen(Context& ctx) {
-    llvm::Value* value = ctx.named_values[declaration];
+    llvm::Value* value = ctx.named_values[declaration->slot];
     if (!value) {
         std::cout << "Unknown variable \"" + declaration->name + "\"" + '\n';
         return nullptr;
     }
 
-    if (!dynamic_cast<ResolvedParamDeclare*>(declaration)) {
-        return ctx.load_value(value, ctx.llvm_types.at(type));
+    // Only `mut` variables live in memory; parameters and `let` bindings are already SSA values
+    const auto* var_decl = dynamic_cast<const ResolvedVarDeclare*>(declaration);
+    if (var_decl && var_decl->is_mutable) {
+        return ctx.load_value(value, ctx.get_llvm_type(type));
     }
     return value;
 }
@@ -394,10 +945,256 @@ llvm::Value* ResolvedAssignment::codegen(Context& ctx) {
         ResolvedDecl* declaration = variable->declaration;
         auto binop = ResolvedBinaryExpr{expr->loc, op, expr->type, std::move(variable),
                                         std::move(expr)}; // TODO: Expr->loc is probably incorrect, get the op's loc
+        binop.overflow = overflow;
         llvm::Value* expr = binop.codegen(ctx);
-        return ctx.builder.CreateStore(expr, ctx.named_values[declaration]);
+        return ctx.builder.CreateStore(expr, ctx.named_values[declaration->slot]);
+    }
+    return ctx.builder.CreateStore(codegen_array_copy(ctx, variable->type, *expr, expr->codegen(ctx)),
+                                   ctx.named_values[variable->declaration->slot]);
+}
+
+llvm::Value* ResolvedIndexAssignment::codegen(Context& ctx) {
+    llvm::Value* address = target->codegen_address(ctx);
+    llvm::Value* value = expr->codegen(ctx);
+    if (!address || !value) {
+        return nullptr;
     }
-    return ctx.builder.CreateStore(expr->codegen(ctx), ctx.named_values[variable->declaration]);
+    ctx.set_debug_location(loc);
+
+    if (op != TokenType::ASSIGN) {
+        llvm::Value* old_value = ctx.builder.CreateLoad(ctx.get_llvm_type(target->type), address);
+        value = codegen_binary_op(ctx, op, target->type, overflow, old_value, value, loc);
+    }
+    return ctx.builder.CreateStore(value, address);
+}
+
+llvm::Value* ResolvedArrayLiteral::codegen(Context& ctx) {
+    llvm::Type* element_type = ctx.get_llvm_type(*type.element);
+    llvm::Type* storage_type = llvm::ArrayType::get(element_type, type.length);
+    llvm::AllocaInst* storage = ctx.allocate_stack_variable("array", storage_type);
+
+    if (is_repeat) {
+        llvm::Value* value = elements[0]->codegen(ctx);
+        if (!value) {
+            return nullptr;
+        }
+
+        // A plain loop; with optimizations on, LLVM turns zero fills into memset
+        if (type.length > 0) {
+            llvm::Function* current_function = ctx.builder.GetInsertBlock()->getParent();
+            llvm::BasicBlock* preheader = ctx.builder.GetInsertBlock();
+            llvm::BasicBlock* fill_block = llvm::BasicBlock::Create(ctx.context, "array.fill", current_function);
+            llvm::BasicBlock* exit_block = llvm::BasicBlock::Create(ctx.context, "array.fill.exit", current_function);
+            ctx.builder.CreateBr(fill_block);
+
+            ctx.builder.SetInsertPoint(fill_block);
+            llvm::PHINode* i = ctx.builder.CreatePHI(ctx.builder.getInt64Ty(), 2, "i");
+            i->addIncoming(ctx.builder.getInt64(0), preheader);
+            ctx.builder.CreateStore(value, ctx.builder.CreateInBoundsGEP(element_type, storage, i));
+
+            llvm::Value* next = ctx.builder.CreateNUWAdd(i, ctx.builder.getInt64(1), "i.next");
+            i->addIncoming(next, fill_block);
+            ctx.builder.CreateCondBr(ctx.builder.CreateICmpULT(next, ctx.builder.getInt64(type.length)), fill_block,
+                                     exit_block);
+            ctx.builder.SetInsertPoint(exit_block);
+        }
+    } else {
+        for (size_t i = 0; i < elements.size(); i++) {
+            llvm::Value* value = elements[i]->codegen(ctx);
+            if (!value) {
+                return nullptr;
+            }
+            ctx.builder.CreateStore(value, ctx.builder.CreateConstInBoundsGEP2_64(storage_type, storage, 0, i));
+        }
+    }
+
+    llvm::Value* fat_pointer = llvm::PoisonValue::get(ctx.get_llvm_type(type));
+    fat_pointer = ctx.builder.CreateInsertValue(fat_pointer, storage, 0);
+    return ctx.builder.CreateInsertValue(fat_pointer, ctx.builder.getInt64(type.length), 1);
+}
+
+llvm::Value* ResolvedIndex::codegen_address(Context& ctx) {
+    llvm::Value* base_value = base->codegen(ctx);
+    llvm::Value* index_value = index->codegen(ctx);
+    if (!base_value || !index_value) {
+        return nullptr;
+    }
+    ctx.set_debug_location(loc);
+
+    // Fixed size arrays use their known length, so checks against constant indices fold away
+    llvm::Value* data = ctx.builder.CreateExtractValue(base_value, 0, "data");
+    llvm::Value* length = base->type.ty == Ty::ARRAY ? ctx.builder.getInt64(base->type.length)
+                                                      : ctx.builder.CreateExtractValue(base_value, 1, "len");
+    if (needs_bounds_check) {
+        codegen_bounds_check(ctx, index_value, length, loc);
+    }
+
+    llvm::Type* element_type = base->type == Type::string ? ctx.builder.getInt8Ty() : ctx.get_llvm_type(type);
+    return ctx.builder.CreateInBoundsGEP(element_type, data, index_value);
+}
+
+llvm::Value* ResolvedIndex::codegen(Context& ctx) {
+    llvm::Value* address = codegen_address(ctx);
+    if (!address) {
+        return nullptr;
+    }
+
+    // Bytes of a string are read as int64
+    if (base->type == Type::string) {
+        llvm::Value* byte = ctx.builder.CreateLoad(ctx.builder.getInt8Ty(), address);
+        return ctx.builder.CreateZExt(byte, ctx.builder.getInt64Ty());
+    }
+    return ctx.builder.CreateLoad(ctx.get_llvm_type(type), address);
+}
+
+llvm::Value* ResolvedLen::codegen(Context& ctx) {
+    llvm::Value* value = expr->codegen(ctx);
+    if (!value) {
+        return nullptr;
+    }
+
+    if (expr->type.ty == Ty::ARRAY) {
+        return ctx.builder.getInt64(expr->type.length);
+    }
+    return ctx.builder.CreateExtractValue(value, 1, "len");
+}
+
+llvm::Value* ResolvedVectorLiteral::codegen(Context& ctx) {
+    std::vector<llvm::Value*> values;
+    for (auto&& element : elements) {
+        llvm::Value* value = element->codegen(ctx);
+        if (!value) {
+            return nullptr;
+        }
+        values.push_back(value);
+    }
+
+    if (values.size() == 1) {
+        return ctx.builder.CreateVectorSplat(type.length, values[0]);
+    }
+
+    llvm::Value* vector = llvm::PoisonValue::get(ctx.get_llvm_type(type));
+    for (size_t i = 0; i < values.size(); i++) {
+        vector = ctx.builder.CreateInsertElement(vector, values[i], i);
+    }
+    return vector;
+}
+
+llvm::Value* ResolvedIntrinsic::codegen(Context& ctx) {
+    std::vector<llvm::Value*> values;
+    for (const auto& operand : operands) {
+        llvm::Value* value = operand->codegen(ctx);
+        if (!value) {
+            return nullptr;
+        }
+        values.push_back(value);
+    }
+    ctx.set_debug_location(loc);
+
+    const Type& scalar_type = type.is_vector() ? *type.element : type;
+    if (scalar_type.is_integer()) {
+        bool is_signed = scalar_type.is_signed_integer();
+        switch (op) {
+            case IntrinsicOp::ABS:
+                // abs(MIN) wraps back to MIN rather than being poison
+                return is_signed ? ctx.builder.CreateBinaryIntrinsic(llvm::Intrinsic::abs, values[0],
+                                                                     ctx.builder.getFalse())
+                                 : values[0];
+            case IntrinsicOp::MIN:
+                return ctx.builder.CreateBinaryIntrinsic(is_signed ? llvm::Intrinsic::smin : llvm::Intrinsic::umin,
+                                                         values[0], values[1]);
+            case IntrinsicOp::MAX:
+                return ctx.builder.CreateBinaryIntrinsic(is_signed ? llvm::Intrinsic::smax : llvm::Intrinsic::umax,
+                                                         values[0], values[1]);
+            case IntrinsicOp::POPCOUNT:
+                return ctx.builder.CreateUnaryIntrinsic(llvm::Intrinsic::ctpop, values[0]);
+            case IntrinsicOp::CLZ:
+            case IntrinsicOp::CTZ:
+                // Zero gives the bit width instead of poison. lzcnt and tzcnt do that anyway; elsewhere it's a select
+                return ctx.builder.CreateBinaryIntrinsic(op == IntrinsicOp::CLZ ? llvm::Intrinsic::ctlz
+                                                                                : llvm::Intrinsic::cttz,
+                                                         values[0], ctx.builder.getFalse());
+            case IntrinsicOp::BSWAP:
+                return ctx.builder.CreateUnaryIntrinsic(llvm::Intrinsic::bswap, values[0]);
+            case IntrinsicOp::ROTL:
+            case IntrinsicOp::ROTR: {
+                // A funnel shift of a value with itself is a rotate, and already takes the amount modulo the width
+                auto funnel_shift = op == IntrinsicOp::ROTL ? llvm::Intrinsic::fshl : llvm::Intrinsic::fshr;
+                return ctx.builder.CreateIntrinsic(funnel_shift, {values[0]->getType()},
+                                                   {values[0], values[0], values[1]});
+            }
+            default:
+                llvm_unreachable("Sema only allows abs, min, max and bit operations on integers");
+        }
+    }
+
+    // min and max ignore a NaN operand, like reduce_min and reduce_max
+    static const std::map<IntrinsicOp, llvm::Intrinsic::ID> float_intrinsics{
+        {IntrinsicOp::SQRT, llvm::Intrinsic::sqrt},   {IntrinsicOp::SIN, llvm::Intrinsic::sin},
+        {IntrinsicOp::COS, llvm::Intrinsic::cos},     {IntrinsicOp::EXP, llvm::Intrinsic::exp},
+        {IntrinsicOp::EXP2, llvm::Intrinsic::exp2},   {IntrinsicOp::LOG, llvm::Intrinsic::log},
+        {IntrinsicOp::LOG2, llvm::Intrinsic::log2},   {IntrinsicOp::LOG10, llvm::Intrinsic::log10},
+        {IntrinsicOp::FLOOR, llvm::Intrinsic::floor}, {IntrinsicOp::CEIL, llvm::Intrinsic::ceil},
+        {IntrinsicOp::TRUNC, llvm::Intrinsic::trunc}, {IntrinsicOp::ROUND, llvm::Intrinsic::round},
+        {IntrinsicOp::FMA, llvm::Intrinsic::fma},     {IntrinsicOp::COPYSIGN, llvm::Intrinsic::copysign},
+        {IntrinsicOp::ABS, llvm::Intrinsic::fabs},    {IntrinsicOp::MIN, llvm::Intrinsic::minnum},
+        {IntrinsicOp::MAX, llvm::Intrinsic::maxnum}};
+    return ctx.builder.CreateIntrinsic(float_intrinsics.at(op), {values[0]->getType()}, values);
+}
+
+llvm::Value* ResolvedVectorOp::codegen(Context& ctx) {
+    std::vector<llvm::Value*> values;
+    for (auto&& operand : operands) {
+        llvm::Value* value = operand->codegen(ctx);
+        if (!value) {
+            return nullptr;
+        }
+        values.push_back(value);
+    }
+    ctx.set_debug_location(loc);
+
+    const Type& element_type = operands[0]->type.is_vector() ? *operands[0]->type.element : operands[0]->type;
+    bool is_float = element_type.is_float();
+    bool is_signed = element_type.is_signed_integer();
+    llvm::Value* vector = values[0];
+    switch (op) {
+        case VectorOp::SHUFFLE:
+            if (values.size() == 2) {
+                return ctx.builder.CreateShuffleVector(vector, values[1], lanes);
+            }
+            return ctx.builder.CreateShuffleVector(vector, lanes);
+        case VectorOp::SELECT:
+            return ctx.builder.CreateSelect(vector, values[1], values[2]);
+        case VectorOp::EXTRACT:
+            return ctx.builder.CreateExtractElement(vector, static_cast<uint64_t>(lanes[0]));
+        case VectorOp::INSERT:
+            return ctx.builder.CreateInsertElement(vector, values[1], static_cast<uint64_t>(lanes[0]));
+        case VectorOp::REDUCE_ADD:
+        case VectorOp::REDUCE_MUL: {
+            bool is_add = op == VectorOp::REDUCE_ADD;
+            if (!is_float) {
+                return is_add ? ctx.builder.CreateAddReduce(vector) : ctx.builder.CreateMulReduce(vector);
+            }
+
+            // The lanes are combined in no particular order, which lets this be a tree of vector adds rather than a
+            // chain of scalar ones
+            llvm::Value* identity = llvm::ConstantFP::get(ctx.get_llvm_type(element_type), is_add ? -0.0 : 1.0);
+            llvm::Value* reduction = is_add ? ctx.builder.CreateFAddReduce(identity, vector)
+                                            : ctx.builder.CreateFMulReduce(identity, vector);
+            llvm::cast<llvm::Instruction>(reduction)->setHasAllowReassoc(true);
+            return reduction;
+        }
+        case VectorOp::REDUCE_MIN:
+            return is_float ? ctx.builder.CreateFPMinReduce(vector) : ctx.builder.CreateIntMinReduce(vector, is_signed);
+        case VectorOp::REDUCE_MAX:
+            return is_float ? ctx.builder.CreateFPMaxReduce(vector) : ctx.builder.CreateIntMaxReduce(vector, is_signed);
+        case VectorOp::REDUCE_ANY:
+            return ctx.builder.CreateOrReduce(vector);
+        case VectorOp::REDUCE_ALL:
+            return ctx.builder.CreateAndReduce(vector);
+    }
+
+    llvm_unreachable("Unhandled vector op");
 }
 
 llvm::Value* ResolvedWhile::codegen(Context& ctx) {
@@ -405,22 +1202,126 @@ llvm::Value* ResolvedWhile::codegen(Context& ctx) {
 
     auto* cond = llvm::BasicBlock::Create(ctx.context, "while.cond", current_function);
     auto* body_block = llvm::BasicBlock::Create(ctx.context, "while.body", current_function);
+    auto* latch = llvm::BasicBlock::Create(ctx.context, "while.latch", current_function);
     auto* exit = llvm::BasicBlock::Create(ctx.context, "while.exit", current_function);
 
     ctx.builder.CreateBr(cond);
     ctx.builder.SetInsertPoint(cond);
 
-    llvm::Value* boolean = codegen_comparison(ctx, *condition);
-    ctx.builder.CreateCondBr(boolean, body_block, exit);
+    codegen_branch(ctx, *condition, body_block, exit);
+
+    ctx.builder.SetInsertPoint(body_block);
+    ctx.loop_targets.emplace_back(latch, exit);
+    body->codegen(ctx);
+    ctx.loop_targets.pop_back();
+    ctx.set_debug_location(loc);
+    ctx.builder.CreateBr(latch);
+
+    // The only back edge, even with `continue`s, so the loop metadata has exactly one place to go
+    ctx.builder.SetInsertPoint(latch);
+    llvm::BranchInst* back_edge = ctx.builder.CreateBr(cond); // Goes back to cond
+    if (llvm::MDNode* loop_id = codegen_loop_metadata(ctx, hints, false)) {
+        back_edge->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+    }
+
+    ctx.builder.SetInsertPoint(exit);
+    return nullptr;
+}
+
+// Emitted in rotated form: a guard, then a preheader, a body starting with the induction phis, and a latch with the
+// exit test. Steps other than 1 count iterations on a separate counter, computed up front, so `i + step` never needs to
+// be compared against `end` and can't overflow into the comparison
+llvm::Value* ResolvedFor::codegen(Context& ctx) {
+    llvm::Value* start_value = start->codegen(ctx);
+    llvm::Value* end_value = end->codegen(ctx);
+    llvm::Value* step_value = step ? step->codegen(ctx) : ctx.builder.getInt64(1);
+    if (!start_value || !end_value || !step_value) {
+        return nullptr;
+    }
+    ctx.set_debug_location(loc);
+
+    bool is_signed = start->type == Type::int64;
+    if (needs_step_check) {
+        llvm::Value* zero = ctx.builder.getInt64(0);
+        llvm::Value* positive = is_signed ? ctx.builder.CreateICmpSGT(step_value, zero, "step.positive")
+                                          : ctx.builder.CreateICmpNE(step_value, zero, "step.positive");
+        codegen_runtime_check(ctx, positive, "step", "panic_non_positive_step",
+                              {step_value, ctx.builder.getInt64(loc.line)});
+    }
+
+    llvm::Function* current_function = ctx.builder.GetInsertBlock()->getParent();
+    auto* preheader = llvm::BasicBlock::Create(ctx.context, "for.preheader", current_function);
+    auto* body_block = llvm::BasicBlock::Create(ctx.context, "for.body", current_function);
+    auto* latch = llvm::BasicBlock::Create(ctx.context, "for.latch", current_function);
+    auto* exit = llvm::BasicBlock::Create(ctx.context, "for.exit", current_function);
+
+    llvm::Value* not_empty = is_signed ? ctx.builder.CreateICmpSLT(start_value, end_value, "for.guard")
+                                       : ctx.builder.CreateICmpULT(start_value, end_value, "for.guard");
+    ctx.builder.CreateCondBr(not_empty, preheader, exit);
+
+    ctx.builder.SetInsertPoint(preheader);
+    auto* constant_step = llvm::dyn_cast<llvm::ConstantInt>(step_value);
+    bool unit_step = constant_step && constant_step->isOne();
+    llvm::Value* trip_count = nullptr;
+    if (!unit_step) {
+        // ceil((end - start) / step); start < end, so the difference is exact as an unsigned number
+        llvm::Value* distance = ctx.builder.CreateSub(end_value, start_value, "distance");
+        llvm::Value* distance_minus_one = ctx.builder.CreateSub(distance, ctx.builder.getInt64(1));
+        llvm::Value* last = ctx.builder.CreateUDiv(distance_minus_one, step_value);
+        trip_count = ctx.builder.CreateNUWAdd(last, ctx.builder.getInt64(1), "trip.count");
+    }
+    ctx.builder.CreateBr(body_block);
 
     ctx.builder.SetInsertPoint(body_block);
+    llvm::PHINode* induction = ctx.builder.CreatePHI(ctx.builder.getInt64Ty(), 2, variable->name);
+    induction->addIncoming(start_value, preheader);
+    llvm::PHINode* counter = nullptr;
+    if (!unit_step) {
+        counter = ctx.builder.CreatePHI(ctx.builder.getInt64Ty(), 2, "for.count");
+        counter->addIncoming(ctx.builder.getInt64(0), preheader);
+    }
+
+    ctx.named_values[variable->slot] = induction;
+    ctx.declare_debug_variable(variable->name, variable->type, induction, false, variable->loc);
+    ctx.loop_targets.emplace_back(latch, exit);
     body->codegen(ctx);
-    ctx.builder.CreateBr(cond); // Goes back to cond
+    ctx.loop_targets.pop_back();
+    ctx.set_debug_location(loc);
+    ctx.builder.CreateBr(latch);
+
+    // Only the final iteration's increments can wrap, and those values never reach a use
+    ctx.builder.SetInsertPoint(latch);
+    llvm::Value* next = is_signed ? ctx.builder.CreateNSWAdd(induction, step_value, variable->name + ".next")
+                                  : ctx.builder.CreateNUWAdd(induction, step_value, variable->name + ".next");
+    induction->addIncoming(next, latch);
+
+    llvm::Value* again = nullptr;
+    if (unit_step) {
+        again = is_signed ? ctx.builder.CreateICmpSLT(next, end_value) : ctx.builder.CreateICmpULT(next, end_value);
+    } else {
+        llvm::Value* next_count = ctx.builder.CreateNUWAdd(counter, ctx.builder.getInt64(1), "for.count.next");
+        counter->addIncoming(next_count, latch);
+        again = ctx.builder.CreateICmpULT(next_count, trip_count);
+    }
+    llvm::BranchInst* back_edge = ctx.builder.CreateCondBr(again, body_block, exit);
+    back_edge->setMetadata(llvm::LLVMContext::MD_loop, codegen_loop_metadata(ctx, hints, true));
 
     ctx.builder.SetInsertPoint(exit);
     return nullptr;
 }
 
+llvm::Value* ResolvedBreak::codegen(Context& ctx) {
+    ctx.builder.CreateBr(ctx.loop_targets.back().second);
+    codegen_dead_block(ctx, ctx.builder.getVoidTy(), "break.dead");
+    return nullptr;
+}
+
+llvm::Value* ResolvedContinue::codegen(Context& ctx) {
+    ctx.builder.CreateBr(ctx.loop_targets.back().first);
+    codegen_dead_block(ctx, ctx.builder.getVoidTy(), "continue.dead");
+    return nullptr;
+}
+
 llvm::Value* ResolvedReturn::codegen(Context& ctx) {
     if (value) {
         ctx.builder.CreateRet(value->codegen(ctx));
@@ -428,5 +1329,6 @@ llvm::Value* ResolvedReturn::codegen(Context& ctx) {
         ctx.builder.CreateRet(nullptr);
     }
 
+    codegen_dead_block(ctx, ctx.builder.getVoidTy(), "return.dead");
     return nullptr;
 }
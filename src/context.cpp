@@ -1,16 +1,39 @@
+#include <filesystem>
+
 #include "chung/context.hpp"
 
 Context::Context()
     : context{llvm::LLVMContext()}, builder{llvm::IRBuilder<>(context)},
       module{std::make_unique<llvm::Module>("<module sus>", context)} {
-    declared_types = {{"uint64", Type::uint64},
-                      {"int64", Type::int64},
-                      {"float64", Type::float64},
-                      {"string", Type::string},
-                      {"bool", Type::boolean}};
+    const Type numeric_types[] = {Type::uint8, Type::uint16, Type::uint32,  Type::uint64, Type::int8,
+                                  Type::int16, Type::int32,  Type::int64,   Type::float32, Type::float64};
+    for (const Type& type : numeric_types) {
+        declared_types.emplace(type.name, type);
+    }
+    declared_types.emplace("string", Type::string);
+    declared_types.emplace("bool", Type::boolean);
+
+    // One vector per SSE (128 bit), AVX2 (256 bit) and AVX-512 (512 bit) register, e.g. float64x4 and float32x8 both
+    // fill an AVX2 register. Masks come in every lane count a comparison can produce
+    for (unsigned register_width : {128, 256, 512}) {
+        for (const Type& element : numeric_types) {
+            uint64_t lanes = register_width / element.bit_width();
+            Type vector = Type::vector(element, lanes);
+            Type mask = Type::vector(Type::boolean, lanes);
+            declared_types.emplace(vector.name, vector);
+            declared_types.emplace(mask.name, mask);
+        }
+    }
     llvm_types = {
+        {Type::uint8, llvm::Type::getInt8Ty(context)},
+        {Type::uint16, llvm::Type::getInt16Ty(context)},
+        {Type::uint32, llvm::Type::getInt32Ty(context)},
         {Type::uint64, llvm::Type::getInt64Ty(context)},
+        {Type::int8, llvm::Type::getInt8Ty(context)},
+        {Type::int16, llvm::Type::getInt16Ty(context)},
+        {Type::int32, llvm::Type::getInt32Ty(context)},
         {Type::int64, llvm::Type::getInt64Ty(context)},
+        {Type::float32, llvm::Type::getFloatTy(context)},
         {Type::float64, llvm::Type::getDoubleTy(context)},
         {Type::void_, llvm::Type::getVoidTy(context)},
         {Type::boolean, llvm::Type::getInt1Ty(context)},
@@ -28,9 +51,171 @@ Type Context::get_type(const std::string& type_identifier) {
     return result->second;
 }
 
+llvm::Type* Context::get_llvm_type(const Type& type) {
+    // Arrays and slices share the string's {ptr, len} layout, whatever their element type
+    if (type.is_array_like()) {
+        return llvm_types.at(Type::string);
+    }
+    if (type.is_vector()) {
+        return llvm::FixedVectorType::get(get_llvm_type(*type.element), type.length);
+    }
+    return llvm_types.at(type);
+}
+
+llvm::Constant* Context::get_string_literal(const std::string& string) {
+    auto result = string_literals.find(string);
+    if (result != string_literals.end()) {
+        return result->second;
+    }
+
+    // A literal that's the tail of one already in the pool can just point into it
+    llvm::Constant* pointer = nullptr;
+    for (const auto& [pooled_string, fat_pointer] : string_literals) {
+        size_t offset = pooled_string.size() - string.size();
+        if (pooled_string.size() > string.size() && pooled_string.compare(offset, string.size(), string) == 0) {
+            llvm::Constant* pooled_pointer = fat_pointer->getAggregateElement(0U);
+            pointer = llvm::ConstantExpr::getInBoundsGetElementPtr(builder.getInt8Ty(), pooled_pointer,
+                                                                   builder.getInt64(offset));
+            break;
+        }
+    }
+
+    if (!pointer) {
+        // Null terminated (not counted in the length) so it lands in a mergeable C string section, where the linker
+        // can also merge identical strings and suffixes across object files
+        auto* constant = llvm::ConstantDataArray::getString(context, string, true);
+        auto* global = new llvm::GlobalVariable(*module, constant->getType(), true, llvm::GlobalValue::PrivateLinkage,
+                                                constant, ".str");
+        global->setAlignment(llvm::Align(1));
+        global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+        pointer = global;
+    }
+
+    auto* string_type = llvm::cast<llvm::StructType>(llvm_types.at(Type::string));
+    auto* fat_pointer = llvm::ConstantStruct::get(string_type, {pointer, builder.getInt64(string.size())});
+    string_literals.emplace(string, fat_pointer);
+    return fat_pointer;
+}
+
 llvm::AllocaInst* Context::allocate_stack_variable(std::string_view name, llvm::Type* type) {
     llvm::IRBuilder<> tmpBuilder(context);
     tmpBuilder.SetInsertPoint(variable_insert_point);
 
     return tmpBuilder.CreateAlloca(type, nullptr, name);
 }
+
+void Context::enable_debug_info(const std::string& file_path, bool emit_dwarf, bool is_optimized) {
+    std::filesystem::path path = std::filesystem::absolute(file_path);
+    debug_builder = std::make_unique<llvm::DIBuilder>(*module);
+    debug_file = debug_builder->createFile(path.filename().string(), path.parent_path().string());
+
+    // Like clang does for -Rpass without -g, NoDebug keeps the locations in the IR but emits no DWARF
+    auto emission_kind = emit_dwarf ? llvm::DICompileUnit::FullDebug : llvm::DICompileUnit::NoDebug;
+    debug_unit = debug_builder->createCompileUnit(llvm::dwarf::DW_LANG_C, debug_file, "chung", is_optimized, "", 0, "",
+                                                  emission_kind);
+    module->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    if (emit_dwarf) {
+        module->addModuleFlag(llvm::Module::Max, "Dwarf Version", 5);
+    }
+}
+
+llvm::DIType* Context::get_debug_type(const Type& type) {
+    auto result = debug_types.find(type.name);
+    if (result != debug_types.end()) {
+        return result->second;
+    }
+
+    llvm::DIType* debug_type = nullptr;
+    if (type.is_numeric() || type == Type::boolean) {
+        unsigned encoding = llvm::dwarf::DW_ATE_unsigned;
+        if (type == Type::boolean) {
+            encoding = llvm::dwarf::DW_ATE_boolean;
+        } else if (type.is_float()) {
+            encoding = llvm::dwarf::DW_ATE_float;
+        } else if (type.is_signed_integer()) {
+            encoding = llvm::dwarf::DW_ATE_signed;
+        }
+        debug_type = debug_builder->createBasicType(type.name, type == Type::boolean ? 8 : type.bit_width(), encoding);
+    } else if (type == Type::string || type.is_array_like()) {
+        // The {ptr, len} fat pointer, as a struct so the debugger shows both halves
+        llvm::DIType* element = get_debug_type(type == Type::string ? Type::uint8 : *type.element);
+        llvm::DIType* data = debug_builder->createMemberType(debug_file, "data", debug_file, 0, 64, 64, 0,
+                                                             llvm::DINode::FlagZero,
+                                                             debug_builder->createPointerType(element, 64));
+        llvm::DIType* len = debug_builder->createMemberType(debug_file, "len", debug_file, 0, 64, 64, 64,
+                                                            llvm::DINode::FlagZero, get_debug_type(Type::int64));
+        debug_type = debug_builder->createStructType(debug_file, type.name, debug_file, 0, 128, 64,
+                                                     llvm::DINode::FlagZero, nullptr,
+                                                     debug_builder->getOrCreateArray({data, len}));
+    } else if (type.is_vector()) {
+        llvm::DIType* element = get_debug_type(*type.element);
+        llvm::Metadata* lanes = debug_builder->getOrCreateSubrange(0, static_cast<int64_t>(type.length));
+        debug_type = debug_builder->createVectorType(type.length * element->getSizeInBits(), 0, element,
+                                                     debug_builder->getOrCreateArray({lanes}));
+    }
+
+    debug_types.emplace(type.name, debug_type);
+    return debug_type;
+}
+
+void Context::create_debug_function(llvm::Function* function, SourceLocation loc, const std::vector<Type>& signature) {
+    if (!debug_builder) {
+        return;
+    }
+
+    std::vector<llvm::Metadata*> debug_signature;
+    debug_signature.reserve(signature.size());
+    for (const Type& type : signature) {
+        debug_signature.push_back(get_debug_type(type));
+    }
+
+    auto line = static_cast<unsigned>(loc.line);
+    llvm::DISubroutineType* type =
+        debug_builder->createSubroutineType(debug_builder->getOrCreateTypeArray(debug_signature));
+    auto flags = llvm::DISubprogram::SPFlagDefinition;
+    if (function->hasLocalLinkage()) {
+        flags |= llvm::DISubprogram::SPFlagLocalToUnit;
+    }
+    if (debug_unit->isOptimized()) {
+        flags |= llvm::DISubprogram::SPFlagOptimized;
+    }
+    function->setSubprogram(debug_builder->createFunction(debug_file, function->getName(), function->getName(),
+                                                          debug_file, line, type, line, llvm::DINode::FlagPrototyped,
+                                                          flags));
+}
+
+void Context::set_debug_location(SourceLocation loc) {
+    llvm::BasicBlock* block = builder.GetInsertBlock();
+    llvm::DISubprogram* scope = block ? block->getParent()->getSubprogram() : nullptr;
+    if (!scope) {
+        return;
+    }
+
+    // DWARF columns start at 1, chung's at 0
+    auto line = static_cast<unsigned>(loc.line);
+    auto column = static_cast<unsigned>(loc.column + 1);
+    builder.SetCurrentDebugLocation(llvm::DILocation::get(context, line, column, scope));
+    debug_locations.emplace(std::pair{line, column}, loc);
+}
+
+void Context::declare_debug_variable(const std::string& name, const Type& type, llvm::Value* value, bool in_memory,
+                                     SourceLocation loc, unsigned argument) {
+    llvm::BasicBlock* block = builder.GetInsertBlock();
+    llvm::DISubprogram* scope = block->getParent()->getSubprogram();
+    if (!scope || debug_unit->getEmissionKind() != llvm::DICompileUnit::FullDebug || !value) {
+        return;
+    }
+
+    auto line = static_cast<unsigned>(loc.line);
+    llvm::DIType* debug_type = get_debug_type(type);
+    llvm::DILocalVariable* variable =
+        argument > 0 ? debug_builder->createParameterVariable(scope, name, argument, debug_file, line, debug_type, true)
+                     : debug_builder->createAutoVariable(scope, name, debug_file, line, debug_type, true);
+
+    auto* location = llvm::DILocation::get(context, line, static_cast<unsigned>(loc.column + 1), scope);
+    if (in_memory) {
+        debug_builder->insertDeclare(value, variable, debug_builder->createExpression(), location, block);
+    } else {
+        debug_builder->insertDbgValueIntrinsic(value, variable, debug_builder->createExpression(), location, block);
+    }
+}
@@ -0,0 +1,37 @@
+#include "chung/diagnostic.hpp"
+#include "chung/utils/ansi.hpp"
+
+std::string write_snippet(const std::vector<std::string>& source_lines, const SourceLocation& loc, const char* color) {
+    const std::string& source_line = source_lines[loc.line - 1];
+    std::string carets;
+
+    for (size_t i = 0; i <= source_line.length(); i++) {
+        if (i == loc.column) {
+            carets += color;
+        }
+        if (i == loc.column + loc.token_length) {
+            carets += ANSI_RESET;
+        }
+
+        if (loc.column <= i && i < loc.column + loc.token_length) {
+            carets += '^';
+        } else {
+            carets += '~';
+        }
+    }
+
+    std::string string;
+    if (loc.line > 1) {
+        string += "|\t" + source_lines[loc.line - 1 - 1] + '\n';
+    }
+
+    string += "|\t";
+    string += std::string{color} + source_line + ANSI_RESET + '\n';
+    string += "|\t" + carets + '\n';
+
+    if (loc.line < source_lines.size()) {
+        string += "|\t" + source_lines[loc.line] + '\n';
+    }
+
+    return string;
+}
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <iostream>
+#include <map>
 #include <string>
 #include <cwctype>
 #include <utility>
@@ -47,6 +49,22 @@ Lexer::Lexer(const std::string& source) : source{source}, cursor{0} {
     source_lines.push_back(source.substr(start));
 }
 
+std::optional<TokenType> Lexer::lex_overflow_op(TokenType op) {
+    static const std::map<std::pair<TokenType, char>, TokenType> overflow_ops{
+        {{TokenType::ADD, '%'}, TokenType::ADD_WRAP},      {{TokenType::SUB, '%'}, TokenType::SUB_WRAP},
+        {{TokenType::MUL, '%'}, TokenType::MUL_WRAP},      {{TokenType::ADD, '!'}, TokenType::ADD_UNCHECKED},
+        {{TokenType::SUB, '!'}, TokenType::SUB_UNCHECKED}, {{TokenType::MUL, '!'}, TokenType::MUL_UNCHECKED},
+        {{TokenType::ADD, '?'}, TokenType::ADD_CHECKED},   {{TokenType::SUB, '?'}, TokenType::SUB_CHECKED},
+        {{TokenType::MUL, '?'}, TokenType::MUL_CHECKED}};
+
+    auto overflow_op = overflow_ops.find({op, peek()});
+    if (overflow_op == overflow_ops.end()) {
+        return std::nullopt;
+    }
+    advance();
+    return overflow_op->second;
+}
+
 std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
     std::vector<Token> tokens;
     std::vector<LexException> exceptions;
@@ -86,6 +104,16 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                         type = TokenType::ELSE;
                     } else if (identifier == "while") {
                         type = TokenType::WHILE;
+                    } else if (identifier == "for") {
+                        type = TokenType::FOR;
+                    } else if (identifier == "in") {
+                        type = TokenType::IN;
+                    } else if (identifier == "break") {
+                        type = TokenType::BREAK;
+                    } else if (identifier == "continue") {
+                        type = TokenType::CONTINUE;
+                    } else if (identifier == "export") {
+                        type = TokenType::EXPORT;
                     } else if (identifier == "__omg") {
                         type = TokenType::__OMG;
                     } else if (identifier == "return") {
@@ -117,52 +145,34 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                     advance();
                 }
 
-                char suffix = peek();
-                std::string token_string = source.substr(start, cursor - start);
-                TokenType type = TokenType::INVALID;
-
-                switch (suffix) {
-                    case 'u':
-                    case 'U': // Unsigned
-                        try {
-                            type = TokenType::UINT64;
-                            advance();
-                        } catch (...) {
-                            // L
-                            tokens.push_back(make_token(TokenType::INVALID, start, cursor));
-                            throw LexException{"Value " + token_string + " too large to store in an uint64", start,
-                                               cursor};
-                        }
-                        break;
-
-                    case '.': { // Floating point
-                        size_t decimal_start = cursor;
+                TokenType type = TokenType::INT64;
+                // `0..n` is a range, not the float `0.`
+                if (peek() == '.' && source[cursor + 1] != '.') { // Floating point
+                    type = TokenType::FLOAT64;
+                    advance();
+                    while (std::iswdigit(peek())) {
                         advance();
-                        while (std::iswdigit(peek())) {
-                            advance();
-                        }
-                        std::string float_string = token_string + source.substr(decimal_start, cursor - decimal_start);
-
-                        try {
-                            type = TokenType::FLOAT64;
-                        } catch (...) {
-                            tokens.push_back(make_token(TokenType::INVALID, start, cursor));
-                            throw LexException{"Value " + float_string + " too large to store in an float64", start,
-                                               cursor};
-                        }
-                        break;
                     }
+                }
 
-                    default:
-                        try {
-                            type = TokenType::INT64;
-                        } catch (...) {
-                            // L
-                            tokens.push_back(make_token(TokenType::INVALID, start, cursor));
-                            throw LexException{"Value " + token_string + " too large to store in an int64", start,
-                                               cursor};
-                        }
-                        break;
+                // Type suffixes, e.g. 255u8, 1000i16 or 0.5f32. A bare `u` means uint64
+                size_t suffix_start = cursor;
+                while (is_identifier_char(peek()) || std::iswdigit(peek())) {
+                    advance();
+                }
+                std::string suffix = source.substr(suffix_start, cursor - suffix_start);
+                if (!suffix.empty()) {
+                    static const std::vector<std::string> integer_suffixes{"u",  "U",   "u8",  "u16", "u32", "u64",
+                                                                           "i8", "i16", "i32", "i64"};
+                    if (suffix == "f32" || suffix == "f64") {
+                        type = TokenType::FLOAT64;
+                    } else if (type == TokenType::INT64 && std::find(integer_suffixes.begin(), integer_suffixes.end(),
+                                                                     suffix) != integer_suffixes.end()) {
+                        type = suffix[0] == 'i' ? TokenType::INT64 : TokenType::UINT64;
+                    } else {
+                        tokens.push_back(make_token(TokenType::INVALID, start, cursor));
+                        throw LexException{"Invalid suffix '" + suffix + "' on numeric literal", start, cursor};
+                    }
                 }
 
                 tokens.push_back(make_token(type, start, cursor));
@@ -185,6 +195,7 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                             HANDLE_ESCAPE_SEQUENCE(U'\"', U'\"')
                             HANDLE_ESCAPE_SEQUENCE(U'\'', U'\'')
                             HANDLE_ESCAPE_SEQUENCE(U'\\', U'\\')
+                            HANDLE_ESCAPE_SEQUENCE(U'0', U'\0')
 
                             // Goofy
                             HANDLE_ESCAPE_SEQUENCE(U'a', U'\a')
@@ -213,6 +224,8 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                         } else if (peek() == '=') { // Sub assign (-=)
                             advance();
                             tokens.push_back(make_token(TokenType::SUB_ASSIGN, cursor - 2, cursor));
+                        } else if (auto overflow_op = lex_overflow_op(TokenType::SUB)) {
+                            tokens.push_back(make_token(*overflow_op, cursor - 2, cursor));
                         } else {
                             tokens.push_back(make_token(TokenType::SUB, cursor - 1, cursor));
                         }
@@ -240,6 +253,14 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                         if (peek() == '=') {
                             advance();
                             tokens.push_back(make_token(TokenType::GREATER_EQUAL, cursor - 2, cursor));
+                        } else if (peek() == '>') {
+                            advance();
+                            if (peek() == '=') { // Shift right assign (>>=)
+                                advance();
+                                tokens.push_back(make_token(TokenType::SHIFT_RIGHT_ASSIGN, cursor - 3, cursor));
+                            } else {
+                                tokens.push_back(make_token(TokenType::SHIFT_RIGHT, cursor - 2, cursor));
+                            }
                         } else {
                             tokens.push_back(make_token(TokenType::GREATER_THAN, cursor - 1, cursor));
                         }
@@ -250,6 +271,14 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                         if (peek() == '=') {
                             advance();
                             tokens.push_back(make_token(TokenType::LESS_EQUAL, cursor - 2, cursor));
+                        } else if (peek() == '<') {
+                            advance();
+                            if (peek() == '=') { // Shift left assign (<<=)
+                                advance();
+                                tokens.push_back(make_token(TokenType::SHIFT_LEFT_ASSIGN, cursor - 3, cursor));
+                            } else {
+                                tokens.push_back(make_token(TokenType::SHIFT_LEFT, cursor - 2, cursor));
+                            }
                         } else {
                             tokens.push_back(make_token(TokenType::LESS_THAN, cursor - 1, cursor));
                         }
@@ -264,11 +293,59 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                             tokens.push_back(make_token(TokenType::ASSIGN, cursor - 1, cursor));
                         }
                         break;
+                    case '!':
+                        advance();
+                        if (peek() == '=') {
+                            advance();
+                            tokens.push_back(make_token(TokenType::NOT_EQUAL, cursor - 2, cursor));
+                        } else {
+                            throw LexException{"Expected '=' after '!'; use 'not' for logical negation", cursor - 1,
+                                               cursor};
+                        }
+                        break;
+                    case '%':
+                        advance();
+                        if (peek() == '=') {
+                            advance();
+                            tokens.push_back(make_token(TokenType::MOD_ASSIGN, cursor - 2, cursor));
+                        } else {
+                            tokens.push_back(make_token(TokenType::MOD, cursor - 1, cursor));
+                        }
+                        break;
+                    case '&':
+                        advance();
+                        if (peek() == '=') {
+                            advance();
+                            tokens.push_back(make_token(TokenType::BITWISE_AND_ASSIGN, cursor - 2, cursor));
+                        } else {
+                            tokens.push_back(make_token(TokenType::BITWISE_AND, cursor - 1, cursor));
+                        }
+                        break;
+                    case '|':
+                        advance();
+                        if (peek() == '=') {
+                            advance();
+                            tokens.push_back(make_token(TokenType::BITWISE_OR_ASSIGN, cursor - 2, cursor));
+                        } else {
+                            tokens.push_back(make_token(TokenType::BITWISE_OR, cursor - 1, cursor));
+                        }
+                        break;
+                    case '^':
+                        advance();
+                        if (peek() == '=') {
+                            advance();
+                            tokens.push_back(make_token(TokenType::BITWISE_XOR_ASSIGN, cursor - 2, cursor));
+                        } else {
+                            tokens.push_back(make_token(TokenType::BITWISE_XOR, cursor - 1, cursor));
+                        }
+                        break;
                     case '+':
                         advance();
                         if (peek() == '=') {
                             advance();
                             tokens.push_back(make_token(TokenType::ADD_ASSIGN, cursor - 2, cursor));
+                        } else if (auto overflow_op = lex_overflow_op(TokenType::ADD)) {
+                            tokens.push_back(make_token(*overflow_op, cursor - 2, cursor));
                         } else {
                             tokens.push_back(make_token(TokenType::ADD, cursor - 1, cursor));
                         }
@@ -278,6 +355,11 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                         if (peek() == '=') {
                             advance();
                             tokens.push_back(make_token(TokenType::MUL_ASSIGN, cursor - 2, cursor));
+                        } else if (peek() == '*') {
+                            advance();
+                            tokens.push_back(make_token(TokenType::POW, cursor - 2, cursor));
+                        } else if (auto overflow_op = lex_overflow_op(TokenType::MUL)) {
+                            tokens.push_back(make_token(*overflow_op, cursor - 2, cursor));
                         } else {
                             tokens.push_back(make_token(TokenType::MUL, cursor - 1, cursor));
                         }
@@ -290,10 +372,21 @@ std::pair<std::vector<Token>, std::vector<LexException>> Lexer::lex() {
                         HANDLE_SIMPLE(TokenType::OPEN_BRACES, '{')
                         HANDLE_SIMPLE(TokenType::CLOSE_BRACES, '}')
 
-                        HANDLE_SIMPLE(TokenType::DOT, '.')
+                    case '.':
+                        advance();
+                        if (peek() == '.') {
+                            advance();
+                            tokens.push_back(make_token(TokenType::RANGE, cursor - 2, cursor));
+                        } else {
+                            tokens.push_back(make_token(TokenType::DOT, cursor - 1, cursor));
+                        }
+                        break;
+
                         HANDLE_SIMPLE(TokenType::COMMA, ',')
                         HANDLE_SIMPLE(TokenType::COLON, ':')
                         HANDLE_SIMPLE(TokenType::SEMICOLON, ';')
+                        HANDLE_SIMPLE(TokenType::AT, '@')
+                        HANDLE_SIMPLE(TokenType::BITWISE_NOT, '~')
 
                     default:
                         tokens.push_back(make_token(TokenType::INVALID, cursor, cursor + 1));
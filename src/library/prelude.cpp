@@ -1,28 +1,525 @@
 #include "chung/library/prelude.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = ::write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        data += written;
+        len -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// All printing goes through one big buffer that's handed to write(2) directly, skipping stdio and its per-call
+// locking. Chung programs are single threaded, so the buffer doesn't need a lock of its own
+class OutputBuffer {
+public:
+    OutputBuffer() : is_tty{isatty(STDOUT_FILENO) == 1} {
+    }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    // Runs at exit, after main returns or exit() is called
+    ~OutputBuffer() {
+        flush();
+    }
+
+    void write(const char* data, size_t len) {
+        if (len > capacity - size) {
+            flush();
+
+            // Not worth copying through the buffer
+            if (len >= capacity) {
+                write_all(STDOUT_FILENO, data, len); // Nowhere left to report errors
+                return;
+            }
+        }
+
+        std::memcpy(buffer + size, data, len);
+        size += len;
+
+        // Someone's watching, so show whole lines as they come
+        if (is_tty && std::memchr(data, '\n', len)) {
+            flush();
+        }
+    }
+
+    // Hands out room for up to max_len bytes at the end of the buffer so numbers can be formatted in place. Must be
+    // followed by commit() with the number of bytes actually written
+    char* reserve(size_t max_len) {
+        if (max_len > capacity - size) {
+            flush();
+        }
+        return buffer + size;
+    }
+
+    void commit(size_t len) {
+        bool has_newline = is_tty && std::memchr(buffer + size, '\n', len);
+        size += len;
+
+        if (has_newline) {
+            flush();
+        }
+    }
+
+    void put(char c) {
+        if (size == capacity) {
+            flush();
+        }
+        buffer[size++] = c;
+
+        if (is_tty && c == '\n') {
+            flush();
+        }
+    }
+
+    void flush() {
+        write_all(STDOUT_FILENO, buffer, size);
+        size = 0;
+    }
+
+private:
+    static constexpr size_t capacity = 1 << 16;
+
+    char buffer[capacity];
+    size_t size{0};
+    bool is_tty;
+};
+
+OutputBuffer output;
+
+// Reads stdin in big blocks with read(2) and parses straight out of the buffer. Unconsumed bytes get moved to the
+// front when it's full, and it only grows when a single token or line doesn't fit
+class InputBuffer {
+public:
+    InputBuffer() : buffer(1 << 20) {
+    }
+
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer& operator=(const InputBuffer&) = delete;
+
+    static bool is_space(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Returns the next byte without consuming it, or -1 at the end of input
+    int peek() {
+        if (pos == end && !refill()) {
+            return -1;
+        }
+        return static_cast<unsigned char>(buffer[pos]);
+    }
+
+    bool consume(char c) {
+        if (peek() != static_cast<unsigned char>(c)) {
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    void skip_whitespace() {
+        while (peek() != -1 && is_space(buffer[pos])) {
+            pos++;
+        }
+    }
+
+    // Consumes everything before the first byte matching stop (or the end of input). The view stays valid until the
+    // next read
+    template <typename Stop> std::string_view take_until(Stop stop) {
+        size_t len = 0;
+        while (true) {
+            while (pos + len < end && !stop(buffer[pos + len])) {
+                len++;
+            }
+            if (pos + len < end || !refill()) {
+                break;
+            }
+        }
+
+        std::string_view result{buffer.data() + pos, len};
+        pos += len;
+        return result;
+    }
+
+private:
+    std::vector<char> buffer;
+    size_t pos{0};
+    size_t end{0};
+    bool eof{false};
+
+    // Reads more input after end, keeping [pos, end) intact but not necessarily in place
+    bool refill() {
+        if (eof) {
+            return false;
+        }
+
+        if (end == buffer.size()) {
+            if (pos > 0) {
+                std::memmove(buffer.data(), buffer.data() + pos, end - pos);
+                end -= pos;
+                pos = 0;
+            } else {
+                buffer.resize(buffer.size() * 2);
+            }
+        }
+
+        while (true) {
+            ssize_t count = ::read(STDIN_FILENO, buffer.data() + end, buffer.size() - end);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                eof = true;
+                return false;
+            }
+
+            end += static_cast<size_t>(count);
+            return true;
+        }
+    }
+};
+
+InputBuffer input_buffer;
+
+// Longest outputs: "-9223372036854775808" and "-2.2250738585072014e-308", plus room for a newline
+constexpr size_t max_int64_chars = 24;
+constexpr size_t max_float64_chars = 32;
+
+// These skip printf's format string parsing and locale lookups, which dominate when printing lots of numbers
+size_t format_int64(char* out, int64_t int64) {
+    return static_cast<size_t>(std::to_chars(out, out + max_int64_chars, int64).ptr - out);
+}
+
+// Shortest representation that parses back to the same double. Integral values get a ".0" so they still read as
+// floats, the same way they'd be written in chung
+size_t format_float64(char* out, double float64) {
+    char* end = std::to_chars(out, out + max_float64_chars, float64).ptr;
+    if (std::find_if(out, end, [](char c) { return c == '.' || c == 'e' || c == 'n' || c == 'i'; }) == end) {
+        *end++ = '.';
+        *end++ = '0';
+    }
+    return static_cast<size_t>(end - out);
+}
+
+// The returned strings are heap allocated and never freed, like every other runtime string for now
+str copy_string(std::string_view text) {
+    char* sigma = static_cast<char*>(std::malloc(text.size()));
+    std::memcpy(sigma, text.data(), text.size());
+    return str{sigma, static_cast<int64_t>(text.size())};
+}
+
+// Chung strings aren't null terminated
+std::string to_path(const char* path, int64_t path_len) {
+    return {path, static_cast<size_t>(path_len)};
+}
+
+// Streams a file in big chunks that always end on a line boundary, unless a single line is longer than the buffer.
+// Whatever follows the last newline is carried over to the front of the next chunk
+class ChunkReader {
+public:
+    explicit ChunkReader(int fd) : fd{fd}, buffer(4 << 20) {
+    }
+
+    ChunkReader(const ChunkReader&) = delete;
+    ChunkReader& operator=(const ChunkReader&) = delete;
+
+    ~ChunkReader() {
+        close(fd);
+    }
+
+    // The chunk stays valid until the next call. Empty once the file is exhausted
+    std::string_view next() {
+        std::memmove(buffer.data(), buffer.data() + chunk_end, end - chunk_end);
+        end -= chunk_end;
+
+        while (!eof && end < buffer.size()) {
+            ssize_t count = ::read(fd, buffer.data() + end, buffer.size() - end);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                eof = true;
+                break;
+            }
+            end += static_cast<size_t>(count);
+        }
+
+        chunk_end = end;
+        if (!eof) {
+            size_t last_line_end = end;
+            while (last_line_end > 0 && buffer[last_line_end - 1] != '\n') {
+                last_line_end--;
+            }
+            if (last_line_end > 0) {
+                chunk_end = last_line_end;
+            }
+        }
+        return {buffer.data(), chunk_end};
+    }
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t end{0};
+    size_t chunk_end{0};
+    bool eof{false};
+};
+
+// Handles given to chung code are indices in here, closed readers leave a null behind
+std::vector<std::unique_ptr<ChunkReader>> readers;
+
+// Runtime errors: show everything printed so far, then the error, and exit
+[[noreturn]] void panic(const std::string& message, int64_t line) {
+    output.flush();
+
+    std::string text = "Runtime error on line " + std::to_string(line) + ": " + message + "\n";
+    write_all(STDERR_FILENO, text.data(), text.size());
+    _exit(1);
+}
+
+std::string_view read_token_view() {
+    input_buffer.skip_whitespace();
+    return input_buffer.take_until(InputBuffer::is_space);
+}
+} // namespace
+
 extern "C" {
-#include <cstdio>
-#include <cinttypes>
 #include <raylib.h>
 
 void print(int64_t int64) {
-    printf("%" PRId64 "\n", int64);
+    char* text = output.reserve(max_int64_chars);
+    size_t len = format_int64(text, int64);
+    text[len++] = '\n';
+    output.commit(len);
 }
 
 void print_char(int64_t int64) {
-    printf("%c", (char)int64);
+    output.put(static_cast<char>(int64));
 }
 
 void print_float64(double float64) {
-    printf("%f\n", float64);
+    char* text = output.reserve(max_float64_chars);
+    size_t len = format_float64(text, float64);
+    text[len++] = '\n';
+    output.commit(len);
 }
 
-using str = struct {
-    char* sigma;
-    int64_t len;
-};
+void print_string(const char* sigma, int64_t len) {
+    output.write(sigma, static_cast<size_t>(len));
+}
+
+str int64_to_string(int64_t int64) {
+    char text[max_int64_chars];
+    return copy_string({text, format_int64(text, int64)});
+}
+
+str float64_to_string(double float64) {
+    char text[max_float64_chars];
+    return copy_string({text, format_float64(text, float64)});
+}
+
+void flush() {
+    output.flush();
+}
+
+// Called by bounds checks in generated code
+void panic_index_out_of_bounds(int64_t index, int64_t len, int64_t line) {
+    panic("index " + std::to_string(index) + " is out of bounds for length " + std::to_string(len), line);
+}
+
+// Called before range loops whose step isn't a literal
+void panic_non_positive_step(int64_t step, int64_t line) {
+    panic("range step must be positive, got " + std::to_string(step), line);
+}
+
+// Called by integer division and remainder
+void panic_division_by_zero(int64_t line) {
+    panic("division by zero", line);
+}
+
+void panic_division_overflow(int64_t line) {
+    panic("division overflow", line);
+}
+
+// Called by +, - and * when overflow traps, either with --overflow=trap or through +? -? *?
+void panic_integer_overflow(int64_t line) {
+    panic("integer overflow", line);
+}
+
+// Called by integer ** when the exponent isn't a literal
+void panic_negative_exponent(int64_t exponent, int64_t line) {
+    panic("integer exponent must not be negative, got " + std::to_string(exponent), line);
+}
+
+// Input. Numbers that fail to parse and reads past the end of input give 0 or an empty string
+int64_t read_int64() {
+    std::string_view token = read_token_view();
+    const char* first = token.data();
+    if (!token.empty() && token[0] == '+') {
+        first++;
+    }
+
+    int64_t int64 = 0;
+    std::from_chars(first, token.data() + token.size(), int64);
+    return int64;
+}
+
+double read_float64() {
+    std::string_view token = read_token_view();
+    const char* first = token.data();
+    if (!token.empty() && token[0] == '+') {
+        first++;
+    }
+
+    double float64 = 0.0;
+    std::from_chars(first, token.data() + token.size(), float64);
+    return float64;
+}
+
+str read_token() {
+    return copy_string(read_token_view());
+}
 
-void print_string(const str* s) { fwrite(s->sigma, 1, (size_t)s->len, stdout); }
+// Doesn't include the line ending, "\n" or "\r\n"
+str read_line() {
+    std::string_view line = input_buffer.take_until([](char c) { return c == '\n'; });
+    str result = copy_string(line.size() > 0 && line.back() == '\r' ? line.substr(0, line.size() - 1) : line);
+
+    input_buffer.consume('\n');
+    return result;
+}
+
+str input(const char* prompt, int64_t prompt_len) {
+    print_string(prompt, prompt_len);
+    output.flush();
+    return read_line();
+}
+
+// Skips whitespace, so it's true once there are no tokens left
+bool stdin_eof() {
+    input_buffer.skip_whitespace();
+    return input_buffer.peek() == -1;
+}
+
+// Files. Failing to open or read a file gives an empty string
+str read_file(const char* path, int64_t path_len) {
+    int fd = open(to_path(path, path_len).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return str{nullptr, 0};
+    }
+
+    // st_size is only a hint, some files (pipes, /proc) don't report one. The extra byte is room for the read that
+    // finds the end of the file, so a file that's as big as it says is read straight into the string in one go
+    struct stat info{};
+    size_t capacity = fstat(fd, &info) == 0 && info.st_size > 0 ? static_cast<size_t>(info.st_size) + 1 : 1 << 16;
+    char* contents = static_cast<char*>(std::malloc(capacity));
+    size_t size = 0;
+
+    while (true) {
+        if (size == capacity) {
+            capacity *= 2;
+            contents = static_cast<char*>(std::realloc(contents, capacity));
+        }
+
+        ssize_t count = ::read(fd, contents + size, capacity - size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        size += static_cast<size_t>(count);
+    }
+    close(fd);
+
+    return str{contents, static_cast<int64_t>(size)};
+}
+
+// Zero copy: the string points straight at the page cache. The mapping lives until the program exits
+str map_file(const char* path, int64_t path_len) {
+    int fd = open(to_path(path, path_len).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return str{nullptr, 0};
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return str{nullptr, 0};
+    }
+
+    auto size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference
+    if (data == MAP_FAILED) {
+        return str{nullptr, 0};
+    }
+
+    // Files are almost always scanned front to back, so have the kernel read ahead aggressively
+    madvise(data, size, MADV_SEQUENTIAL);
+    return str{static_cast<char*>(data), static_cast<int64_t>(size)};
+}
+
+bool write_file(const char* path, int64_t path_len, const char* contents, int64_t contents_len) {
+    int fd = open(to_path(path, path_len).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool written = write_all(fd, contents, static_cast<size_t>(contents_len));
+    return close(fd) == 0 && written;
+}
+
+// Returns -1 if the file can't be opened
+int64_t open_reader(const char* path, int64_t path_len) {
+    int fd = open(to_path(path, path_len).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    readers.push_back(std::make_unique<ChunkReader>(fd));
+    return static_cast<int64_t>(readers.size() - 1);
+}
+
+// The chunk is overwritten by the next read_chunk on the same reader
+str read_chunk(int64_t reader) {
+    if (reader < 0 || static_cast<size_t>(reader) >= readers.size() || !readers[reader]) {
+        return str{nullptr, 0};
+    }
+
+    std::string_view chunk = readers[reader]->next();
+    return str{const_cast<char*>(chunk.data()), static_cast<int64_t>(chunk.size())};
+}
+
+void close_reader(int64_t reader) {
+    if (reader >= 0 && static_cast<size_t>(reader) < readers.size()) {
+        readers[reader].reset();
+    }
+}
 
 // Raylib
 void init_window(int64_t width, int64_t height) {
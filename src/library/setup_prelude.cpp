@@ -1,10 +1,26 @@
 #include "chung/library/setup_prelude.hpp"
 
-void setup_function(Context& ctx, const std::string& name, const std::vector<std::pair<std::string, llvm::Type*>>& params,
-                    llvm::Type* return_type) {
-    std::vector<llvm::Type*> params_type;
-    params_type.reserve(params.size());
+#include <llvm/Support/ModRef.h>
+
+llvm::Function* setup_function(Context& ctx, const std::string& name,
+                               const std::vector<std::pair<std::string, llvm::Type*>>& params, llvm::Type* return_type) {
+    // String parameters are split into a pointer and a length, which the C calling convention passes in two
+    // registers. Returned strings stay as the struct, since a 16 byte struct already comes back in registers
+    llvm::Type* string_type = ctx.llvm_types.at(Type::string);
+    std::vector<std::pair<std::string, llvm::Type*>> c_params;
+    c_params.reserve(params.size());
     for (const auto& param : params) {
+        if (param.second == string_type) {
+            c_params.emplace_back(param.first, llvm::PointerType::get(ctx.context, 0));
+            c_params.emplace_back(param.first + "_len", llvm::Type::getInt64Ty(ctx.context));
+        } else {
+            c_params.push_back(param);
+        }
+    }
+
+    std::vector<llvm::Type*> params_type;
+    params_type.reserve(c_params.size());
+    for (const auto& param : c_params) {
         params_type.push_back(param.second);
     }
     llvm::FunctionType* func_type = llvm::FunctionType::get(return_type, params_type, false);
@@ -13,11 +29,42 @@ void setup_function(Context& ctx, const std::string& name, const std::vector<std
 
     size_t i = 0;
     for (auto& arg : func->args()) {
-        arg.setName(params[i].first);
+        arg.setName(c_params[i].first);
         i++;
     }
-    
-    ctx.c_builtins.push_back(name);
+
+    // The prelude is plain C (and C++ compiled without exceptions leaking out), so nothing unwinds into chung code
+    func->setDoesNotThrow();
+
+    return func;
+}
+
+// Printing only touches libc's stdout state, which generated code never sees, so LLVM can keep chung values in
+// registers across the call. It always returns, but stdio locking counts as synchronization
+void set_print_attributes(llvm::Function* func) {
+    func->setMemoryEffects(llvm::MemoryEffects::inaccessibleOrArgMemOnly());
+    func->addFnAttr(llvm::Attribute::WillReturn);
+
+    for (auto& arg : func->args()) {
+        if (arg.getType()->isPointerTy()) {
+            arg.addAttr(llvm::Attribute::ReadOnly);
+            arg.addAttr(llvm::Attribute::NoUndef);
+            arg.addAttr(llvm::Attribute::getWithCaptureInfo(func->getContext(), llvm::CaptureInfo::none()));
+        }
+    }
+}
+
+// Formatting and reading stdin only touch the runtime's own state (malloc, the input buffer) and always return
+void set_runtime_attributes(llvm::Function* func) {
+    func->setMemoryEffects(llvm::MemoryEffects::inaccessibleMemOnly());
+    func->addFnAttr(llvm::Attribute::WillReturn);
+}
+
+// Panics flush stdout's buffer and write to stderr, which is runtime state generated code never sees
+void set_panic_attributes(llvm::Function* func) {
+    func->setMemoryEffects(llvm::MemoryEffects::inaccessibleMemOnly());
+    func->addFnAttr(llvm::Attribute::NoReturn);
+    func->addFnAttr(llvm::Attribute::Cold);
 }
 
 void setup_prelude(Context& ctx) {
@@ -25,11 +72,41 @@ void setup_prelude(Context& ctx) {
     llvm::Type* void_type = llvm::Type::getVoidTy(ctx.context);
     llvm::Type* bool_type = llvm::Type::getInt1Ty(ctx.context);
 
-    setup_function(ctx, "print", {{"value", llvm::Type::getInt64Ty(ctx.context)}}, llvm::Type::getVoidTy(ctx.context));
-    setup_function(ctx, "print_char", {{"value", llvm::Type::getInt64Ty(ctx.context)}}, llvm::Type::getVoidTy(ctx.context));
-    setup_function(ctx, "print_float64", {{"value", llvm::Type::getDoubleTy(ctx.context)}}, llvm::Type::getVoidTy(ctx.context));
-    // setup_function(ctx, "print_string", {{"value", ctx.llvm_types.at(Type::string)}}, llvm::Type::getVoidTy(ctx.context));
-    setup_function(ctx, "print_string", {{"value", llvm::PointerType::get(ctx.context, 0)}}, void_type);
+    set_print_attributes(setup_function(ctx, "print", {{"value", llvm::Type::getInt64Ty(ctx.context)}}, llvm::Type::getVoidTy(ctx.context)));
+    set_print_attributes(setup_function(ctx, "print_char", {{"value", llvm::Type::getInt64Ty(ctx.context)}}, llvm::Type::getVoidTy(ctx.context)));
+    set_print_attributes(setup_function(ctx, "print_float64", {{"value", llvm::Type::getDoubleTy(ctx.context)}}, llvm::Type::getVoidTy(ctx.context)));
+    llvm::Type* string_type = ctx.llvm_types.at(Type::string);
+    set_print_attributes(setup_function(ctx, "print_string", {{"value", string_type}}, void_type));
+    set_print_attributes(setup_function(ctx, "flush", {}, void_type));
+
+    set_runtime_attributes(setup_function(ctx, "int64_to_string", {{"value", int64_type}}, string_type));
+    set_runtime_attributes(setup_function(ctx, "float64_to_string", {{"value", llvm::Type::getDoubleTy(ctx.context)}}, string_type));
+
+    // Reading stdin
+    set_runtime_attributes(setup_function(ctx, "read_int64", {}, int64_type));
+    set_runtime_attributes(setup_function(ctx, "read_float64", {}, llvm::Type::getDoubleTy(ctx.context)));
+    set_runtime_attributes(setup_function(ctx, "read_token", {}, string_type));
+    set_runtime_attributes(setup_function(ctx, "read_line", {}, string_type));
+    set_print_attributes(setup_function(ctx, "input", {{"prompt", string_type}}, string_type));
+    set_runtime_attributes(setup_function(ctx, "stdin_eof", {}, bool_type));
+
+    // Files. Chunks are reused by the next read_chunk on the same reader, which chung code can see, so the chunk
+    // reader functions can't claim to only touch runtime state
+    set_print_attributes(setup_function(ctx, "read_file", {{"path", string_type}}, string_type));
+    set_print_attributes(setup_function(ctx, "map_file", {{"path", string_type}}, string_type));
+    set_print_attributes(setup_function(ctx, "write_file", {{"path", string_type}, {"contents", string_type}}, bool_type));
+    set_print_attributes(setup_function(ctx, "open_reader", {{"path", string_type}}, int64_type));
+    setup_function(ctx, "read_chunk", {{"reader", int64_type}}, string_type)->addFnAttr(llvm::Attribute::WillReturn);
+    setup_function(ctx, "close_reader", {{"reader", int64_type}}, void_type)->addFnAttr(llvm::Attribute::WillReturn);
+
+    // Runtime checks in generated code call these when they fail. Marking them cold moves the failure paths out of
+    // the way, and noreturn tells LLVM the checked condition holds afterwards
+    set_panic_attributes(setup_function(ctx, "panic_index_out_of_bounds", {{"index", int64_type}, {"len", int64_type}, {"line", int64_type}}, void_type));
+    set_panic_attributes(setup_function(ctx, "panic_non_positive_step", {{"step", int64_type}, {"line", int64_type}}, void_type));
+    set_panic_attributes(setup_function(ctx, "panic_division_by_zero", {{"line", int64_type}}, void_type));
+    set_panic_attributes(setup_function(ctx, "panic_division_overflow", {{"line", int64_type}}, void_type));
+    set_panic_attributes(setup_function(ctx, "panic_integer_overflow", {{"line", int64_type}}, void_type));
+    set_panic_attributes(setup_function(ctx, "panic_negative_exponent", {{"exponent", int64_type}, {"line", int64_type}}, void_type));
 
     // Raylib
     setup_function(ctx, "init_window", {{"width", int64_type}, {"height", int64_type}}, void_type);
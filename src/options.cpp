@@ -0,0 +1,82 @@
+#include <map>
+
+#include "chung/options.hpp"
+
+static std::optional<std::string> parse_overflow_mode(const std::string& value, CompileOptions& options) {
+    static const std::map<std::string, OverflowMode> modes{
+        {"wrap", OverflowMode::WRAP}, {"undefined", OverflowMode::UNDEFINED}, {"trap", OverflowMode::TRAP}};
+
+    auto mode = modes.find(value);
+    if (mode == modes.end()) {
+        return "Unknown overflow mode '" + value + "', expected wrap, undefined or trap";
+    }
+    options.overflow = mode->second;
+    return std::nullopt;
+}
+
+std::optional<FpContract> parse_fp_contract(const std::string& value) {
+    static const std::map<std::string, FpContract> modes{
+        {"off", FpContract::OFF}, {"on", FpContract::ON}, {"fast", FpContract::FAST}};
+
+    auto mode = modes.find(value);
+    if (mode == modes.end()) {
+        return std::nullopt;
+    }
+    return mode->second;
+}
+
+std::optional<std::string> parse_compile_options(const std::vector<std::string>& flags, CompileOptions& options) {
+    for (const auto& flag : flags) {
+        size_t equals = flag.find('=');
+        std::string name = flag.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : flag.substr(equals + 1);
+
+        std::optional<std::string> error;
+        if (name == "--overflow") {
+            error = parse_overflow_mode(value, options);
+        } else if (flag == "--fast-math") {
+            options.float_model.fast_math = true;
+        } else if (name == "--fp-contract") {
+            if (auto contract = parse_fp_contract(value)) {
+                options.float_model.contract = *contract;
+            } else {
+                error = "Unknown fp-contract mode '" + value + "', expected off, on or fast";
+            }
+        } else if (flag.size() == 3 && flag.compare(0, 2, "-O") == 0 && flag[2] >= '0' && flag[2] <= '3') {
+            options.opt_level = flag[2] - '0';
+        } else if (flag == "-g") {
+            options.debug_info = true;
+        } else if (flag == "-fno-omit-frame-pointer" || flag == "-fomit-frame-pointer") {
+            options.frame_pointers = flag == "-fno-omit-frame-pointer";
+        } else if (name == "--profile-generate") {
+            // Same default as clang, where %m keeps the profiles of different binaries apart
+            options.profile_generate = value.empty() ? "default_%m.profraw" : value;
+        } else if (name == "--profile-use") {
+            if (value.empty()) {
+                error = "Expected a profile after '--profile-use='";
+            }
+            options.profile_use = value;
+        } else if (name == "--remarks") {
+            if (value.empty()) {
+                error = "Expected a pass regex after '--remarks='";
+            }
+            options.remarks = value;
+        } else if (name == "--remarks-output") {
+            if (value.empty()) {
+                error = "Expected a file after '--remarks-output='";
+            }
+            options.remarks_output = value;
+        } else {
+            error = "Unknown option '" + flag + "'";
+        }
+
+        if (error) {
+            return error;
+        }
+    }
+
+    if (options.profile_generate && options.profile_use) {
+        return "'--profile-generate' and '--profile-use' can't be used together";
+    }
+    return std::nullopt;
+}
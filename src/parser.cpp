@@ -1,10 +1,12 @@
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 #include <unordered_map>
 
+#include "chung/diagnostic.hpp"
 #include "chung/parser.hpp"
 #include "chung/token.hpp"
 #include "chung/utils/ansi.hpp"
@@ -17,10 +19,15 @@
 
 int get_op_precedence(TokenType op) {
     static const std::unordered_map<TokenType, int> op_lookup{
-        {TokenType::AND, 10},          {TokenType::OR, 10},         {TokenType::GREATER_EQUAL, 20},
-        {TokenType::GREATER_THAN, 20}, {TokenType::LESS_EQUAL, 20}, {TokenType::LESS_THAN, 20},
-        {TokenType::EQUAL, 20},        {TokenType::ADD, 30},        {TokenType::SUB, 30},
-        {TokenType::MUL, 40},          {TokenType::DIV, 40},        {TokenType::MOD, 40},
+        {TokenType::AND, 10},          {TokenType::OR, 10},          {TokenType::GREATER_EQUAL, 20},
+        {TokenType::GREATER_THAN, 20}, {TokenType::LESS_EQUAL, 20},  {TokenType::LESS_THAN, 20},
+        {TokenType::EQUAL, 20},        {TokenType::NOT_EQUAL, 20},   {TokenType::BITWISE_OR, 22},
+        {TokenType::BITWISE_XOR, 24},  {TokenType::BITWISE_AND, 26}, {TokenType::SHIFT_LEFT, 28},
+        {TokenType::SHIFT_RIGHT, 28},  {TokenType::ADD, 30},         {TokenType::SUB, 30},
+        {TokenType::ADD_WRAP, 30},     {TokenType::SUB_WRAP, 30},    {TokenType::ADD_UNCHECKED, 30},
+        {TokenType::SUB_UNCHECKED, 30}, {TokenType::ADD_CHECKED, 30}, {TokenType::SUB_CHECKED, 30},
+        {TokenType::MUL, 40},          {TokenType::DIV, 40},         {TokenType::MOD, 40},
+        {TokenType::MUL_WRAP, 40},     {TokenType::MUL_UNCHECKED, 40}, {TokenType::MUL_CHECKED, 40},
         {TokenType::POW, 50}};
 
     auto result = op_lookup.find(op);
@@ -38,34 +45,7 @@ std::string ParseException::write(const std::vector<std::string>& source_lines)
     std::string string{ANSI_RED};
     string += "ParseException at line " + std::to_string(token.loc.line) + " column " +
               std::to_string(token.loc.column) + ":\n" + ANSI_RESET;
-    std::string carets;
-
-    for (size_t i = 0; i <= source_line.length(); i++) {
-        if (i == token.loc.column) {
-            carets += ANSI_RED;
-        }
-        if (i == token.loc.column + token.loc.token_length) {
-            carets += ANSI_RESET;
-        }
-
-        if (token.loc.column <= i && i < token.loc.column + token.loc.token_length) {
-            carets += '^';
-        } else {
-            carets += '~';
-        }
-    }
-
-    if (token.loc.line > 0) {
-        string += "|\t" + source_lines[token.loc.line - 1 - 1] + '\n';
-    }
-
-    string += "|\t";
-    string += std::string{ANSI_RED} + source_line + ANSI_RESET + '\n';
-    string += "|\t" + carets + '\n';
-
-    if (token.loc.line < source_lines.size()) {
-        string += "|\t" + source_lines[token.loc.line] + '\n';
-    }
+    string += write_snippet(source_lines, token.loc, ANSI_RED);
     string += ANSI_RED + exception_message + ANSI_RESET + '\n';
 
     return string;
@@ -125,6 +105,9 @@ std::unique_ptr<ExprAST> Parser::parse_call() {
 
     // Eat ')'
     eat_token();
+    if (ctx.declared_types.count(callee.text)) {
+        return std::make_unique<ConstructAST>(callee.loc, ctx.get_type(callee.text), std::move(arguments));
+    }
     return std::make_unique<CallAST>(callee.loc, callee.text, std::move(arguments));
 }
 
@@ -135,11 +118,91 @@ std::unique_ptr<ExprAST> Parser::parse_identifier() {
     if (next.type != TokenType::OPEN_PARENTHESES) {
         // Eat identifier
         eat_token();
-        return std::make_unique<VariableAST>(token.loc, token.text);
+        return parse_postfix(std::make_unique<VariableAST>(token.loc, token.text));
     }
 
     // A call
-    return parse_call();
+    return parse_postfix(parse_call());
+}
+
+std::unique_ptr<ExprAST> Parser::parse_postfix(std::unique_ptr<ExprAST> expr) {
+    while (expr && current_token().type == TokenType::OPEN_BRACKETS) {
+        SourceLocation loc = current_token().loc;
+
+        // Eat '['
+        eat_token();
+        std::unique_ptr<ExprAST> index = parse_expression();
+        if (!index) {
+            throw push_exception("Expected index expression after '['", current_token());
+        }
+        match_simple(TokenType::CLOSE_BRACKETS, "Expected ']' after index");
+
+        expr = std::make_unique<IndexExprAST>(loc, std::move(expr), std::move(index));
+    }
+    return expr;
+}
+
+std::unique_ptr<ExprAST> Parser::parse_array_literal() {
+    SourceLocation loc = current_token().loc;
+
+    // Eat '['
+    eat_token();
+
+    std::vector<std::unique_ptr<ExprAST>> elements;
+    std::optional<uint64_t> repeat_count;
+    while (current_token().type != TokenType::CLOSE_BRACKETS) {
+        auto element = parse_expression();
+        if (!element) {
+            throw push_exception("Expected element in array literal", current_token());
+        }
+        elements.push_back(std::move(element));
+
+        // [value; N]
+        if (elements.size() == 1 && current_token().type == TokenType::SEMICOLON) {
+            eat_token();
+            repeat_count = parse_array_length();
+            break;
+        }
+
+        if (current_token().type == TokenType::COMMA) {
+            eat_token();
+        } else if (current_token().type != TokenType::CLOSE_BRACKETS) {
+            throw push_exception("Expected ',' or ']' in array literal", current_token());
+        }
+    }
+
+    // Eat ']'
+    match_simple(TokenType::CLOSE_BRACKETS, "Expected ']' at end of array literal");
+    return parse_postfix(std::make_unique<ArrayLiteralAST>(loc, std::move(elements), repeat_count));
+}
+
+uint64_t Parser::parse_array_length() {
+    Token length = current_token();
+    match_simple(TokenType::INT64, "Expected integer literal for array length");
+    return std::stoull(length.text);
+}
+
+Type Parser::parse_type() {
+    // []T or [T; N]
+    if (current_token().type == TokenType::OPEN_BRACKETS) {
+        // Eat '['
+        eat_token();
+        if (current_token().type == TokenType::CLOSE_BRACKETS) {
+            // Eat ']'
+            eat_token();
+            return Type::slice(parse_type());
+        }
+
+        Type element = parse_type();
+        match_simple(TokenType::SEMICOLON, "Expected ';' between array element type and length");
+        uint64_t length = parse_array_length();
+        match_simple(TokenType::CLOSE_BRACKETS, "Expected ']' after array length");
+        return Type::array(element, length);
+    }
+
+    Token type_name = current_token();
+    match_simple(TokenType::IDENTIFIER, "Expected type");
+    return ctx.get_type(type_name.text);
 }
 
 std::unique_ptr<ExprAST> Parser::parse_parentheses() {
@@ -152,7 +215,7 @@ std::unique_ptr<ExprAST> Parser::parse_parentheses() {
 
     // Eat ')'
     match_simple(TokenType::CLOSE_PARENTHESES, "Expected closing parenthesis ')'");
-    return expr;
+    return parse_postfix(std::move(expr));
 }
 
 std::unique_ptr<ExprAST> Parser::parse_unary() {
@@ -161,13 +224,19 @@ std::unique_ptr<ExprAST> Parser::parse_unary() {
     }
 
     Token op = eat_token();
-    if (op.type != TokenType::SUB && op.type != TokenType::NOT) { // Only minus and not is allowed so far
+    if (op.type != TokenType::SUB && op.type != TokenType::NOT && op.type != TokenType::BITWISE_NOT) {
         throw push_exception("Operator cannot be used as unary expression", op);
     }
-    if (auto operand = parse_unary()) {
-        return std::make_unique<UnaryExprAST>(op.loc, op.type, std::move(operand));
+    auto operand = parse_unary();
+    if (!operand) {
+        return nullptr;
+    }
+
+    // ** binds tighter than the unary operators, so -2 ** 2 is -(2 ** 2)
+    if (current_token().type == TokenType::POW) {
+        operand = parse_bin_op(get_op_precedence(TokenType::POW), std::move(operand));
     }
-    return nullptr;
+    return std::make_unique<UnaryExprAST>(op.loc, op.type, std::move(operand));
 }
 
 std::unique_ptr<ExprAST> Parser::parse_bin_op(int min_op_precedence, std::unique_ptr<ExprAST> lhs) {
@@ -184,8 +253,11 @@ std::unique_ptr<ExprAST> Parser::parse_bin_op(int min_op_precedence, std::unique
         eat_token();
         std::unique_ptr<ExprAST> rhs = parse_unary();
 
+        // ** is right associative, so 2 ** 3 ** 2 is 2 ** 9
         int next_op_precedence = get_op_precedence(current_token().type);
-        if (op_precedence < next_op_precedence) {
+        if (op.type == TokenType::POW && current_token().type == TokenType::POW) {
+            rhs = parse_bin_op(op_precedence, std::move(rhs));
+        } else if (op_precedence < next_op_precedence) {
             rhs = parse_bin_op(op_precedence + 1, std::move(rhs));
         }
 
@@ -208,8 +280,12 @@ std::unique_ptr<ExprAST> Parser::parse_primary() {
     } else if (is_symbol(token.type)) {
         if (token.type == TokenType::OPEN_PARENTHESES) {
             return parse_parentheses();
+        } else if (token.type == TokenType::OPEN_BRACKETS) {
+            return parse_array_literal();
         } else if (token.type == TokenType::OPEN_BRACES) {
             return parse_block();
+        } else if (token.type == TokenType::AT) {
+            return parse_attributed_expr();
         }
         return nullptr;
     } else {
@@ -238,13 +314,23 @@ std::unique_ptr<BlockAST> Parser::parse_block() {
         // Otherwise, we try to parse an expression statement
         auto expr_stmt = parse_expression_statement(false); // Will handle later
         ExprAST* expr = (dynamic_cast<ExprStmtAST*>(expr_stmt.get())->expr).get();
+        static const std::unordered_map<TokenType, TokenType> compound_assignments{
+            {TokenType::ADD_ASSIGN, TokenType::ADD},
+            {TokenType::SUB_ASSIGN, TokenType::SUB},
+            {TokenType::MUL_ASSIGN, TokenType::MUL},
+            {TokenType::DIV_ASSIGN, TokenType::DIV},
+            {TokenType::MOD_ASSIGN, TokenType::MOD},
+            {TokenType::BITWISE_AND_ASSIGN, TokenType::BITWISE_AND},
+            {TokenType::BITWISE_OR_ASSIGN, TokenType::BITWISE_OR},
+            {TokenType::BITWISE_XOR_ASSIGN, TokenType::BITWISE_XOR},
+            {TokenType::SHIFT_LEFT_ASSIGN, TokenType::SHIFT_LEFT},
+            {TokenType::SHIFT_RIGHT_ASSIGN, TokenType::SHIFT_RIGHT}};
         TokenType token_type = current_token().type;
-        if (token_type == TokenType::ASSIGN || token_type == TokenType::ADD_ASSIGN ||
-            token_type == TokenType::SUB_ASSIGN || token_type == TokenType::MUL_ASSIGN ||
-            token_type == TokenType::DIV_ASSIGN) {
+        if (token_type == TokenType::ASSIGN || compound_assignments.count(token_type)) {
             auto* var_decl = dynamic_cast<VariableAST*>(expr);
-            if (!var_decl) {
-                throw push_exception("Expected variable expression on the LHS of the assignment",
+            auto* index_expr = dynamic_cast<IndexExprAST*>(expr);
+            if (!var_decl && !index_expr) {
+                throw push_exception("Expected variable or index expression on the LHS of the assignment",
                                      current_token());
             }
 
@@ -254,19 +340,18 @@ std::unique_ptr<BlockAST> Parser::parse_block() {
             // Eat '='
             TokenType assign_op = eat_token().type;
             TokenType op = assign_op;
-            if (assign_op == TokenType::ADD_ASSIGN) {
-                op = TokenType::ADD;
-            } else if (assign_op == TokenType::SUB_ASSIGN) {
-                op = TokenType::SUB;
-            } else if (assign_op == TokenType::MUL_ASSIGN) {
-                op = TokenType::MUL;
-            } else if (assign_op == TokenType::DIV_ASSIGN){
-                op = TokenType::DIV;
+            if (auto compound = compound_assignments.find(assign_op); compound != compound_assignments.end()) {
+                op = compound->second;
             }
 
             auto rhs_expr = parse_expression();
-            statements.push_back(std::make_unique<AssignmentAST>(loc, std::unique_ptr<VariableAST>(var_decl),
-                                                                 op, std::move(rhs_expr)));
+            if (index_expr) {
+                statements.push_back(std::make_unique<IndexAssignmentAST>(
+                    loc, std::unique_ptr<IndexExprAST>(index_expr), op, std::move(rhs_expr)));
+            } else {
+                statements.push_back(std::make_unique<AssignmentAST>(loc, std::unique_ptr<VariableAST>(var_decl), op,
+                                                                     std::move(rhs_expr)));
+            }
 
             // Eat ';'
             match_simple(TokenType::SEMICOLON, "Expected ';' after assignment");
@@ -313,9 +398,7 @@ std::unique_ptr<StmtAST> Parser::parse_var_declaration() {
     if (current_token().type == TokenType::COLON) {
         // Eat ':'
         eat_token();
-        Token type_name = current_token();
-        match_simple(TokenType::IDENTIFIER, "Expected type after ':' in variable declaration");
-        type = ctx.get_type(type_name.text);
+        type = parse_type();
     }
 
     std::unique_ptr<ExprAST> expr = nullptr;
@@ -355,9 +438,7 @@ std::unique_ptr<StmtAST> Parser::parse_function() {
         match_simple(TokenType::COLON, "Expected ':' after parameter name to specify parameter type");
 
         Token type_name = current_token();
-        match_simple(TokenType::IDENTIFIER, "Expected type in parameter declaration");
-
-        Type type = ctx.get_type(type_name.text);
+        Type type = parse_type();
         if (type.ty == Ty::INVALID) {
             throw push_exception("Type does not exist", type_name);
         }
@@ -383,15 +464,26 @@ std::unique_ptr<StmtAST> Parser::parse_function() {
         // Eat '->'
         eat_token();
 
-        Token type_name = current_token();
-        match_simple(TokenType::IDENTIFIER, "Expected type in function return type declaration");
-        type = ctx.get_type(type_name.text);
+        type = parse_type();
     }
 
     return std::make_unique<FunctionAST>(name.loc, name.text, std::move(parameters), type,
                                          parse_block()); // parse_block() -> body
 }
 
+std::unique_ptr<StmtAST> Parser::parse_export() {
+    // Eat 'export'
+    eat_token();
+
+    if (current_token().type != TokenType::FUNC) {
+        throw push_exception("Expected 'func' after 'export'", current_token());
+    }
+
+    auto function = parse_function();
+    dynamic_cast<FunctionAST*>(function.get())->is_exported = true;
+    return function;
+}
+
 std::unique_ptr<ExprAST> Parser::parse_if_expr() {
     SourceLocation loc = next_token().loc;
     // Eat 'if'
@@ -444,6 +536,130 @@ std::unique_ptr<StmtAST> Parser::parse_while() {
     return std::make_unique<WhileAST>(loc, std::move(condition), std::move(body));
 }
 
+std::unique_ptr<StmtAST> Parser::parse_for() {
+    SourceLocation loc = current_token().loc;
+
+    // Eat 'for'
+    eat_token();
+
+    Token variable = current_token();
+    match_simple(TokenType::IDENTIFIER, "Expected loop variable after 'for' keyword");
+    match_simple(TokenType::IN, "Expected 'in' after loop variable");
+
+    std::unique_ptr<ExprAST> start = parse_expression();
+    if (!start) {
+        throw push_exception("Expected start of range", current_token());
+    }
+    match_simple(TokenType::RANGE, "Expected '..' after start of range");
+    std::unique_ptr<ExprAST> end = parse_expression();
+    if (!end) {
+        throw push_exception("Expected end of range", current_token());
+    }
+
+    // `step` is only a keyword here
+    std::unique_ptr<ExprAST> step;
+    if (current_token().type == TokenType::IDENTIFIER && current_token().text == "step") {
+        eat_token();
+        step = parse_expression();
+        if (!step) {
+            throw push_exception("Expected step after 'step'", current_token());
+        }
+    }
+
+    std::unique_ptr<BlockAST> body = parse_block();
+
+    return std::make_unique<ForAST>(loc, variable.text, std::move(start), std::move(end), std::move(step),
+                                    std::move(body));
+}
+
+// break; or continue;
+std::unique_ptr<StmtAST> Parser::parse_loop_control() {
+    Token keyword = eat_token();
+    match_simple(TokenType::SEMICOLON, "Expected ';' after '" + keyword.text + "'");
+
+    if (keyword.type == TokenType::BREAK) {
+        return std::make_unique<BreakAST>(keyword.loc);
+    }
+    return std::make_unique<ContinueAST>(keyword.loc);
+}
+
+std::vector<AttributeAST> Parser::parse_attributes() {
+    std::vector<AttributeAST> attributes;
+
+    while (current_token().type == TokenType::AT) {
+        // Eat '@'
+        eat_token();
+
+        Token name = current_token();
+        match_simple(TokenType::IDENTIFIER, "Expected attribute name after '@'");
+
+        std::vector<std::unique_ptr<ExprAST>> arguments;
+        if (current_token().type == TokenType::OPEN_PARENTHESES) {
+            eat_token();
+            while (current_token().type != TokenType::CLOSE_PARENTHESES) {
+                std::unique_ptr<ExprAST> argument = parse_expression();
+                if (!argument) {
+                    throw push_exception("Expected attribute argument", current_token());
+                }
+                arguments.push_back(std::move(argument));
+
+                if (current_token().type != TokenType::COMMA) {
+                    break;
+                }
+                eat_token();
+            }
+            match_simple(TokenType::CLOSE_PARENTHESES, "Expected ')' after attribute arguments");
+        }
+
+        attributes.emplace_back(name.loc, name.text, std::move(arguments));
+    }
+
+    return attributes;
+}
+
+std::unique_ptr<StmtAST> Parser::parse_attributed_statement() {
+    SourceLocation loc = current_token().loc;
+    std::vector<AttributeAST> attributes = parse_attributes();
+
+    switch (current_token().type) {
+        case TokenType::WHILE: {
+            auto loop = parse_while();
+            dynamic_cast<WhileAST*>(loop.get())->attributes = std::move(attributes);
+            return loop;
+        }
+        case TokenType::FOR: {
+            auto loop = parse_for();
+            dynamic_cast<ForAST*>(loop.get())->attributes = std::move(attributes);
+            return loop;
+        }
+        case TokenType::FUNC:
+        case TokenType::EXPORT: {
+            auto function = current_token().type == TokenType::FUNC ? parse_function() : parse_export();
+            dynamic_cast<FunctionAST*>(function.get())->attributes = std::move(attributes);
+            return function;
+        }
+        default: {
+            // Otherwise it's an expression statement starting with an attributed expression, like `@likely(x);`
+            if (attributes.size() != 1) {
+                throw push_exception("Attributes can only be applied to loops and functions", current_token());
+            }
+            std::unique_ptr<ExprAST> expr = std::make_unique<AttributedExprAST>(loc, std::move(attributes[0]));
+            expr = parse_bin_op(0, std::move(expr));
+            match_simple(TokenType::SEMICOLON, "Expected ';' after expression");
+            return std::make_unique<ExprStmtAST>(expr->loc, std::move(expr));
+        }
+    }
+}
+
+std::unique_ptr<ExprAST> Parser::parse_attributed_expr() {
+    SourceLocation loc = current_token().loc;
+    std::vector<AttributeAST> attributes = parse_attributes();
+    if (attributes.size() != 1) {
+        throw push_exception("Expected a single attribute around the expression", current_token());
+    }
+    return std::make_unique<AttributedExprAST>(loc, std::move(attributes[0]));
+}
+
 std::unique_ptr<StmtAST> Parser::parse_return() {
     SourceLocation loc = current_token().loc;
 
@@ -504,6 +720,9 @@ std::unique_ptr<StmtAST> Parser::parse_expression_statement(bool require_semicol
 std::unique_ptr<StmtAST> Parser::parse_statement() {
     try {
         Token token = current_token();
+        if (token.type == TokenType::AT) {
+            return parse_attributed_statement();
+        }
         if (is_keyword(token.type)) {
             switch (token.type) {
                 case TokenType::LET:
@@ -511,10 +730,17 @@ std::unique_ptr<StmtAST> Parser::parse_statement() {
                     return parse_var_declaration();
                 case TokenType::FUNC:
                     return parse_function();
+                case TokenType::EXPORT:
+                    return parse_export();
                 case TokenType::__OMG:
                     return parse_omg();
                 case TokenType::WHILE:
                     return parse_while();
+                case TokenType::FOR:
+                    return parse_for();
+                case TokenType::BREAK:
+                case TokenType::CONTINUE:
+                    return parse_loop_control();
                 case TokenType::RETURN:
                     return parse_return();
                 default: {
@@ -0,0 +1,82 @@
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/Function.h>
+
+#include "chung/diagnostic.hpp"
+#include "chung/remarks.hpp"
+#include "chung/utils/ansi.hpp"
+
+std::string Remark::write(const std::vector<std::string>& source_lines) const {
+    static const std::map<RemarkKind, std::pair<const char*, const char*>> kinds{
+        {RemarkKind::PASSED, {ANSI_GREEN, "Passed"}},
+        {RemarkKind::MISSED, {ANSI_YELLOW, "Missed"}},
+        {RemarkKind::ANALYSIS, {ANSI_CYAN, "Analysis"}}};
+    const auto& [color, kind_name] = kinds.at(kind);
+
+    std::string string{color};
+    string += std::string{kind_name} + " remark from " + pass + " in " + function;
+    if (!loc || loc->line == 0 || loc->line > source_lines.size()) {
+        string += std::string{":\n"} + ANSI_RESET + message + '\n';
+        return string;
+    }
+    string += " at line " + std::to_string(loc->line) + " column " + std::to_string(loc->column) + ":\n" + ANSI_RESET;
+
+    string += write_snippet(source_lines, *loc, color);
+    string += color + message + ANSI_RESET + '\n';
+
+    return string;
+}
+
+bool RemarkCollector::handleDiagnostics(const llvm::DiagnosticInfo& info) {
+    const auto* remark = llvm::dyn_cast<llvm::DiagnosticInfoOptimizationBase>(&info);
+    if (!remark) {
+        return false; // Errors and warnings keep LLVM's own printing
+    }
+    if (!remark->isEnabled()) {
+        return true;
+    }
+
+    RemarkKind kind = RemarkKind::ANALYSIS;
+    switch (info.getKind()) {
+        case llvm::DK_OptimizationRemark:
+        case llvm::DK_MachineOptimizationRemark:
+            kind = RemarkKind::PASSED;
+            break;
+        case llvm::DK_OptimizationRemarkMissed:
+        case llvm::DK_MachineOptimizationRemarkMissed:
+            kind = RemarkKind::MISSED;
+            break;
+        default:
+            break;
+    }
+
+    std::optional<SourceLocation> loc;
+    if (remark->isLocationAvailable()) {
+        llvm::DiagnosticLocation location = remark->getLocation();
+        auto found = locations.find({location.getLine(), location.getColumn()});
+        if (found != locations.end()) {
+            loc = found->second;
+        } else {
+            loc = SourceLocation{location.getLine(), location.getColumn() > 0 ? location.getColumn() - 1 : 0, 1};
+        }
+    }
+
+    remarks.push_back(Remark{kind, remark->getPassName().str(), remark->getFunction().getName().str(),
+                             remark->getMsg(), loc});
+    return true;
+}
+
+bool RemarkCollector::isAnalysisRemarkEnabled(llvm::StringRef pass_name) const {
+    return pass_regex.match(pass_name);
+}
+
+bool RemarkCollector::isMissedOptRemarkEnabled(llvm::StringRef pass_name) const {
+    return pass_regex.match(pass_name);
+}
+
+bool RemarkCollector::isPassedOptRemarkEnabled(llvm::StringRef pass_name) const {
+    return pass_regex.match(pass_name);
+}
+
+bool RemarkCollector::isAnyRemarkEnabled() const {
+    return true;
+}
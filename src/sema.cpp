@@ -2,10 +2,14 @@
 #include "chung/ast.hpp"
 #include "chung/token.hpp"
 #include "chung/type.hpp"
+#include "chung/diagnostic.hpp"
 #include "chung/utils/ansi.hpp"
 #include "chung/sema.hpp"
 #include <llvm/Support/ErrorHandling.h>
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <set>
 
 #define HANDLE_MAKE_VAR(identifier, initialization)                                                                    \
     auto identifier = (initialization);                                                                                \
@@ -19,34 +23,7 @@ std::string SemaException::write(const std::vector<std::string>& source_lines) {
     std::string string{ANSI_RED};
     string += "SemaException at line " + std::to_string(loc.line) + " column " + std::to_string(loc.column) + ":\n" +
               ANSI_RESET;
-    std::string carets;
-
-    for (size_t i = 0; i <= source_line.length(); i++) {
-        if (i == loc.column) {
-            carets += ANSI_RED;
-        }
-        if (i == loc.column + loc.token_length) {
-            carets += ANSI_RESET;
-        }
-
-        if (loc.column <= i && i < loc.column + loc.token_length) {
-            carets += '^';
-        } else {
-            carets += '~';
-        }
-    }
-
-    if (loc.line > 0) {
-        string += "|\t" + source_lines[loc.line - 1 - 1] + '\n';
-    }
-
-    string += "|\t";
-    string += std::string{ANSI_RED} + source_line + ANSI_RESET + '\n';
-    string += "|\t" + carets + '\n';
-
-    if (loc.line < source_lines.size()) {
-        string += "|\t" + source_lines[loc.line] + '\n';
-    }
+    string += write_snippet(source_lines, loc, ANSI_RED);
     string += ANSI_RED + exception_message + ANSI_RESET + '\n';
 
     return string;
@@ -118,10 +95,30 @@ std::unique_ptr<ResolvedStmt> Sema::resolve_stmt(const StmtAST& stmt) {
         return resolve_while(*while_loop);
     }
 
+    if (const auto* for_loop = dynamic_cast<const ForAST*>(&stmt)) {
+        return resolve_for(*for_loop);
+    }
+
+    if (dynamic_cast<const BreakAST*>(&stmt) || dynamic_cast<const ContinueAST*>(&stmt)) {
+        bool is_break = dynamic_cast<const BreakAST*>(&stmt);
+        if (loop_depth == 0) {
+            push_exception(std::string{is_break ? "'break'" : "'continue'"} + " outside of a loop", stmt.loc);
+            return nullptr;
+        }
+        if (is_break) {
+            return std::make_unique<ResolvedBreak>(stmt.loc);
+        }
+        return std::make_unique<ResolvedContinue>(stmt.loc);
+    }
+
     if (const auto* return_stmt = dynamic_cast<const ReturnAST*>(&stmt)) {
         return resolve_return(*return_stmt);
     }
 
+    if (const auto* index_assignment = dynamic_cast<const IndexAssignmentAST*>(&stmt)) {
+        return resolve_index_assignment(*index_assignment);
+    }
+
     // Every stmt should be covered already; if not, implementation error
     llvm_unreachable("Unhandled statement in Sema::resolve_stmt");
 }
@@ -147,6 +144,10 @@ std::unique_ptr<ResolvedExpr> Sema::resolve_expr(const ExprAST& expr) {
         return resolve_call(*call);
     }
 
+    if (const auto* construct = dynamic_cast<const ConstructAST*>(&expr)) {
+        return resolve_construct(*construct);
+    }
+
     if (const auto* block = dynamic_cast<const BlockAST*>(&expr)) {
         return resolve_block(*block);
     }
@@ -155,6 +156,18 @@ std::unique_ptr<ResolvedExpr> Sema::resolve_expr(const ExprAST& expr) {
         return resolve_unary_expr(*unary_expr);
     }
 
+    if (const auto* array_literal = dynamic_cast<const ArrayLiteralAST*>(&expr)) {
+        return resolve_array_literal(*array_literal);
+    }
+
+    if (const auto* index_expr = dynamic_cast<const IndexExprAST*>(&expr)) {
+        return resolve_index_expr(*index_expr);
+    }
+
+    if (const auto* attributed_expr = dynamic_cast<const AttributedExprAST*>(&expr)) {
+        return resolve_attributed_expr(*attributed_expr);
+    }
+
     // Every expr should be covered already; if not, implementation error
     llvm_unreachable("Unhandled expression in Sema::resolve_expr");
 }
@@ -200,24 +213,103 @@ std::unique_ptr<ResolvedIfExpr> Sema::resolve_if_expr(const IfExprAST& if_expr)
                                             std::move(resolved_body), std::move(resolved_else_body));
 }
 
-std::unique_ptr<ResolvedUnaryExpr> Sema::resolve_unary_expr(const UnaryExprAST& unary_expr) {
+std::unique_ptr<ResolvedExpr> Sema::resolve_unary_expr(const UnaryExprAST& unary_expr) {
+    // Number literals are negated before their range is checked, so every type's minimum (like -128i8) can be written
+    const auto* number = dynamic_cast<const PrimitiveAST*>(unary_expr.expr.get());
+    if (unary_expr.op == TokenType::SUB && number &&
+        (number->type == TokenType::INT64 || number->type == TokenType::UINT64 || number->type == TokenType::FLOAT64)) {
+        HANDLE_MAKE_VAR(negated_number, resolve_number(*number, true))
+        negated_number->loc = unary_expr.loc;
+        return negated_number;
+    }
+
     HANDLE_MAKE_VAR(resolved_unary_expr, resolve_expr(*unary_expr.expr));
 
     if (resolved_unary_expr->type == Type::void_) {
         push_exception("Expression has type void and is incompatible with the unary operator", unary_expr.loc);
         return nullptr;
     }
-    if (unary_expr.op == TokenType::NOT && resolved_unary_expr->type != Type::boolean) {
+    const Type& type = resolved_unary_expr->type;
+    const Type& scalar_type = type.is_vector() ? *type.element : type;
+    if (unary_expr.op == TokenType::NOT && scalar_type != Type::boolean) {
         push_exception("'not' expression must be of type bool", resolved_unary_expr->loc);
         return nullptr;
     }
+    if (unary_expr.op == TokenType::BITWISE_NOT && !scalar_type.is_integer()) {
+        push_exception("'~' expression must be an integer", resolved_unary_expr->loc);
+        return nullptr;
+    }
+    if (unary_expr.op == TokenType::SUB && scalar_type.is_unsigned_integer()) {
+        push_exception("Cannot negate a value of unsigned type " + type.name, resolved_unary_expr->loc);
+        return nullptr;
+    }
+
+    // Negative literals stay literals, so that e.g. -128 can still become an int8
+    auto* literal = dynamic_cast<ResolvedPrimitive*>(resolved_unary_expr.get());
+    if (unary_expr.op == TokenType::SUB && literal && type.is_numeric()) {
+        if (type.is_float()) {
+            literal->float64 = -literal->float64;
+        } else {
+            literal->int64 = static_cast<int64_t>(-static_cast<uint64_t>(literal->int64));
+        }
+        literal->loc = unary_expr.loc;
+        return resolved_unary_expr;
+    }
+
+    auto resolved = std::make_unique<ResolvedUnaryExpr>(unary_expr.loc, unary_expr.op, std::move(resolved_unary_expr));
+    if (unary_expr.op == TokenType::SUB && scalar_type.is_integer()) {
+        // Negating MIN overflows
+        resolved->overflow = options.overflow;
+        current_function->has_traps |= options.overflow == OverflowMode::TRAP;
+    }
+    return resolved;
+}
 
-    return std::make_unique<ResolvedUnaryExpr>(unary_expr.loc, unary_expr.op, std::move(resolved_unary_expr));
+// +%, +! and +? (and the same for - and *) are the plain operator with their own overflow behaviour
+static std::pair<TokenType, std::optional<OverflowMode>> split_overflow_op(TokenType op) {
+    static const std::map<TokenType, std::pair<TokenType, OverflowMode>> overflow_ops{
+        {TokenType::ADD_WRAP, {TokenType::ADD, OverflowMode::WRAP}},
+        {TokenType::SUB_WRAP, {TokenType::SUB, OverflowMode::WRAP}},
+        {TokenType::MUL_WRAP, {TokenType::MUL, OverflowMode::WRAP}},
+        {TokenType::ADD_UNCHECKED, {TokenType::ADD, OverflowMode::UNDEFINED}},
+        {TokenType::SUB_UNCHECKED, {TokenType::SUB, OverflowMode::UNDEFINED}},
+        {TokenType::MUL_UNCHECKED, {TokenType::MUL, OverflowMode::UNDEFINED}},
+        {TokenType::ADD_CHECKED, {TokenType::ADD, OverflowMode::TRAP}},
+        {TokenType::SUB_CHECKED, {TokenType::SUB, OverflowMode::TRAP}},
+        {TokenType::MUL_CHECKED, {TokenType::MUL, OverflowMode::TRAP}}};
+
+    auto overflow_op = overflow_ops.find(op);
+    if (overflow_op == overflow_ops.end()) {
+        return {op, std::nullopt};
+    }
+    return overflow_op->second;
+}
+
+std::unique_ptr<ResolvedExpect> Sema::resolve_attributed_expr(const AttributedExprAST& attributed_expr) {
+    const AttributeAST& attribute = attributed_expr.attribute;
+    if (attribute.name != "likely" && attribute.name != "unlikely") {
+        push_exception("Unknown expression attribute '@" + attribute.name + "'", attribute.loc);
+        return nullptr;
+    }
+    if (attribute.arguments.size() != 1) {
+        push_exception("'@" + attribute.name + "' takes exactly one condition", attribute.loc);
+        return nullptr;
+    }
+
+    HANDLE_MAKE_VAR(condition, resolve_expr(*attribute.arguments[0]))
+    if (condition->type != Type::boolean) {
+        push_exception("Condition must be of type bool", condition->loc);
+        return nullptr;
+    }
+    return std::make_unique<ResolvedExpect>(attributed_expr.loc, std::move(condition), attribute.name == "likely");
 }
 
 std::unique_ptr<ResolvedBinaryExpr> Sema::resolve_binary_expr(const BinaryExprAST& binary_expr) {
     HANDLE_MAKE_VAR(resolved_lhs, resolve_expr(*binary_expr.lhs))
     HANDLE_MAKE_VAR(resolved_rhs, resolve_expr(*binary_expr.rhs))
+    if (binary_expr.op == TokenType::POW) {
+        return resolve_power(binary_expr, std::move(resolved_lhs), std::move(resolved_rhs));
+    }
 
     if (binary_expr.op == TokenType::AND || binary_expr.op == TokenType::OR) {
         if (resolved_lhs->type != Type::boolean) {
@@ -229,38 +321,113 @@ std::unique_ptr<ResolvedBinaryExpr> Sema::resolve_binary_expr(const BinaryExprAS
         }
     }
 
-    if (resolved_lhs->type.ty != resolved_rhs->type.ty) { // TODO: operator up/down, struct, operator overloading?
+    if (resolved_lhs->type != resolved_rhs->type) {
+        // An untyped literal adapts to the other side before anything widens, so 1 + x has the same type as x + 1
+        const auto* literal = dynamic_cast<const ResolvedPrimitive*>(resolved_lhs.get());
+        if (literal && literal->is_untyped) {
+            resolved_lhs = convert_implicitly(std::move(resolved_lhs), resolved_rhs->type);
+        }
+        resolved_rhs = convert_implicitly(std::move(resolved_rhs), resolved_lhs->type);
+        resolved_lhs = convert_implicitly(std::move(resolved_lhs), resolved_rhs->type);
+    }
+    if (resolved_lhs->type != resolved_rhs->type) { // TODO: struct, operator overloading?
         push_exception("Binary expression contains two mismatching types (" + resolved_lhs->type.name +
                            " on left hand vs " + resolved_rhs->type.name + " on right hand)",
                        binary_expr.loc);
         return nullptr;
     }
 
+    auto [op, explicit_overflow] = split_overflow_op(binary_expr.op);
+    const Type& scalar_type = resolved_lhs->type.is_vector() ? *resolved_lhs->type.element : resolved_lhs->type;
+    if (explicit_overflow && !scalar_type.is_integer()) {
+        push_exception("Overflow operators need integer operands, found " + resolved_lhs->type.name, binary_expr.loc);
+        return nullptr;
+    }
+    OverflowMode overflow = explicit_overflow.value_or(options.overflow);
+    if (!check_operands(op, resolved_lhs->type, *resolved_rhs, overflow, binary_expr.loc)) {
+        return nullptr;
+    }
+
     Type type{resolved_lhs->type};
-    if (binary_expr.op == TokenType::EQUAL || binary_expr.op == TokenType::GREATER_THAN ||
-        binary_expr.op == TokenType::LESS_THAN || binary_expr.op == TokenType::GREATER_EQUAL ||
-        binary_expr.op == TokenType::LESS_EQUAL) {
-        type = Type::boolean;
+    if (op == TokenType::EQUAL || op == TokenType::NOT_EQUAL || op == TokenType::GREATER_THAN ||
+        op == TokenType::LESS_THAN || op == TokenType::GREATER_EQUAL || op == TokenType::LESS_EQUAL) {
+        // Vectors compare lane by lane into a mask
+        type = type.is_vector() ? Type::vector(Type::boolean, type.length) : Type::boolean;
     }
 
-    return std::make_unique<ResolvedBinaryExpr>(binary_expr.loc, binary_expr.op, type, std::move(resolved_lhs),
-                                                std::move(resolved_rhs));
+    auto resolved_binary_expr = std::make_unique<ResolvedBinaryExpr>(binary_expr.loc, op, type,
+                                                                      std::move(resolved_lhs), std::move(resolved_rhs));
+    resolved_binary_expr->overflow = overflow;
+    return resolved_binary_expr;
 }
 
-std::unique_ptr<ResolvedPrimitive> Sema::resolve_primitive(const PrimitiveAST& primitive) {
-    switch (primitive.type) {
-        case TokenType::INT64: {
-            int64_t int64 = std::stoll(primitive.value);
-            return std::make_unique<ResolvedPrimitive>(primitive.loc, int64);
+// Unlike the other operators, the exponent of ** needn't have the base's type. Float bases take an exponent of their
+// own type or an integer, where small integers become llvm.powi. Integer bases take any non-negative integer, and
+// integer vectors raise every lane to the same scalar exponent
+std::unique_ptr<ResolvedBinaryExpr> Sema::resolve_power(const BinaryExprAST& power, std::unique_ptr<ResolvedExpr> base,
+                                                        std::unique_ptr<ResolvedExpr> exponent) {
+    const Type& scalar_type = base->type.is_vector() ? *base->type.element : base->type;
+    if (scalar_type.is_float()) {
+        if (exponent->type.is_integer()) {
+            exponent = convert_implicitly(std::move(exponent), Type::int32);
+        } else {
+            exponent = convert_implicitly(std::move(exponent), base->type);
+            base = convert_implicitly(std::move(base), exponent->type);
+        }
+        if (!exponent->type.is_integer() && base->type != exponent->type) {
+            push_exception("Cannot raise " + base->type.name + " to the power of " + exponent->type.name, power.loc);
+            return nullptr;
         }
-        case TokenType::UINT64: {
-            uint64_t uint64 = std::stoull(primitive.value);
-            return std::make_unique<ResolvedPrimitive>(primitive.loc, uint64);
+    } else if (scalar_type.is_integer()) {
+        if (!exponent->type.is_integer()) {
+            push_exception("Integer powers need an integer exponent, found " + exponent->type.name, power.loc);
+            return nullptr;
         }
-        case TokenType::FLOAT64: {
-            double float64 = std::stod(primitive.value);
-            return std::make_unique<ResolvedPrimitive>(primitive.loc, float64);
+
+        // Negative exponents would need a division, so they're rejected, or checked at runtime if not a literal
+        const auto* literal = dynamic_cast<const ResolvedPrimitive*>(exponent.get());
+        bool is_signed = exponent->type.is_signed_integer();
+        if (literal && is_signed && literal->int64 < 0) {
+            push_exception("Integer powers need a non-negative exponent", exponent->loc);
+            return nullptr;
         }
+        current_function->has_traps |= (is_signed && !literal) || options.overflow == OverflowMode::TRAP;
+    } else {
+        push_exception("'**' needs a float or integer base, found " + base->type.name, power.loc);
+        return nullptr;
+    }
+
+    Type type = base->type;
+    auto resolved_power = std::make_unique<ResolvedBinaryExpr>(power.loc, TokenType::POW, std::move(type),
+                                                                std::move(base), std::move(exponent));
+    resolved_power->overflow = options.overflow;
+    return resolved_power;
+}
+
+// Whether an integer's value is representable in `type`
+static bool fits_integer_type(int64_t value, const Type& type) {
+    unsigned bits = type.bit_width();
+    if (type.is_unsigned_integer()) {
+        return value >= 0 && (bits == 64 || static_cast<uint64_t>(value) < (uint64_t{1} << bits));
+    }
+    int64_t max = bits == 64 ? INT64_MAX : (int64_t{1} << (bits - 1)) - 1;
+    return value >= -max - 1 && value <= max;
+}
+
+static std::optional<uint64_t> parse_integer(const std::string& digits) {
+    try {
+        return std::stoull(digits);
+    } catch (const std::out_of_range&) {
+        return std::nullopt;
+    }
+}
+
+std::unique_ptr<ResolvedPrimitive> Sema::resolve_primitive(const PrimitiveAST& primitive) {
+    switch (primitive.type) {
+        case TokenType::INT64:
+        case TokenType::UINT64:
+        case TokenType::FLOAT64:
+            return resolve_number(primitive);
         case TokenType::STRING: {
             return std::make_unique<ResolvedPrimitive>(primitive.loc, primitive.value);
         }
@@ -275,6 +442,105 @@ std::unique_ptr<ResolvedPrimitive> Sema::resolve_primitive(const PrimitiveAST& p
     }
 }
 
+// Operators that only make sense for some operand types. Integer division and checked arithmetic also note the
+// runtime check they need
+bool Sema::check_operands(TokenType op, const Type& type, const ResolvedExpr& rhs, OverflowMode overflow,
+                          SourceLocation loc) {
+    const Type& scalar_type = type.is_vector() ? *type.element : type;
+    switch (op) {
+        case TokenType::ADD:
+        case TokenType::SUB:
+        case TokenType::MUL:
+            current_function->has_traps |= scalar_type.is_integer() && overflow == OverflowMode::TRAP;
+            return true;
+        case TokenType::BITWISE_AND:
+        case TokenType::BITWISE_OR:
+        case TokenType::BITWISE_XOR:
+            if (!scalar_type.is_integer() && scalar_type != Type::boolean) {
+                push_exception("Bitwise operators need integer or bool operands, found " + type.name, loc);
+                return false;
+            }
+            return true;
+        case TokenType::SHIFT_LEFT:
+        case TokenType::SHIFT_RIGHT:
+            if (!scalar_type.is_integer()) {
+                push_exception("Shifts need integer operands, found " + type.name, loc);
+                return false;
+            }
+            return true;
+        case TokenType::DIV:
+        case TokenType::MOD: {
+            if (!scalar_type.is_numeric()) {
+                push_exception("Division needs numeric operands, found " + type.name, loc);
+                return false;
+            }
+
+            // A literal divisor other than 0 (or -1, for signed MIN / -1) can't fail
+            const auto* divisor = dynamic_cast<const ResolvedPrimitive*>(&rhs);
+            bool can_fail =
+                !divisor || divisor->int64 == 0 || (scalar_type.is_signed_integer() && divisor->int64 == -1);
+            current_function->has_traps |= scalar_type.is_integer() && can_fail;
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+std::unique_ptr<ResolvedPrimitive> Sema::resolve_number(const PrimitiveAST& number, bool negate) {
+    static const std::map<std::string, Type> suffix_types{
+        {"u", Type::uint64},   {"U", Type::uint64},   {"u8", Type::uint8},     {"u16", Type::uint16},
+        {"u32", Type::uint32}, {"u64", Type::uint64}, {"i8", Type::int8},      {"i16", Type::int16},
+        {"i32", Type::int32},  {"i64", Type::int64},  {"f32", Type::float32}, {"f64", Type::float64}};
+
+    size_t suffix_start = number.value.find_first_of("iuUf");
+    std::string digits = number.value.substr(0, suffix_start);
+    std::string sign = negate ? "-" : "";
+    std::string too_big = negate ? " is too small to store in an " : " is too large to store in an ";
+
+    // A negated magnitude can be one more than the type's maximum
+    std::optional<uint64_t> value = number.type == TokenType::FLOAT64 ? std::nullopt : parse_integer(digits);
+    bool fits_int64 = value && *value <= uint64_t{INT64_MAX} + negate;
+    int64_t int64 = value ? static_cast<int64_t>(negate ? -*value : *value) : 0;
+
+    if (suffix_start == std::string::npos) {
+        std::unique_ptr<ResolvedPrimitive> resolved_number;
+        if (number.type == TokenType::FLOAT64) {
+            double float64 = std::stod(digits);
+            resolved_number = std::make_unique<ResolvedPrimitive>(number.loc, negate ? -float64 : float64);
+        } else if (fits_int64) {
+            resolved_number = std::make_unique<ResolvedPrimitive>(number.loc, int64);
+        } else {
+            push_exception("Value " + sign + digits + too_big + "int64", number.loc);
+            return nullptr;
+        }
+        resolved_number->is_untyped = true;
+        return resolved_number;
+    }
+
+    const Type& type = suffix_types.at(number.value.substr(suffix_start));
+    if (type.is_float()) {
+        double float64 = std::stod(digits);
+        auto resolved_number = std::make_unique<ResolvedPrimitive>(number.loc, negate ? -float64 : float64);
+        resolved_number->type = type;
+        return resolved_number;
+    }
+    if (negate && type.is_unsigned_integer()) {
+        push_exception("Cannot negate a value of unsigned type " + type.name, number.loc);
+        return nullptr;
+    }
+
+    bool fits = value && (type == Type::uint64 || (fits_int64 && fits_integer_type(int64, type)));
+    if (!fits) {
+        push_exception("Value " + sign + digits + too_big + type.name, number.loc);
+        return nullptr;
+    }
+    auto resolved_number = std::make_unique<ResolvedPrimitive>(number.loc, *value);
+    resolved_number->int64 = int64;
+    resolved_number->type = type;
+    return resolved_number;
+}
+
 std::unique_ptr<ResolvedVariable> Sema::resolve_variable(const VariableAST& variable) {
     auto [resolved_decl, scope_level] = lookup_declaration(variable.name);
     if (!resolved_decl) {
@@ -302,7 +568,8 @@ std::unique_ptr<ResolvedAssignment> Sema::resolve_assignment(const AssignmentAST
                        assignment.loc);
         return nullptr;
     }
-    if (var->type != resolved_expr->type) {
+    resolved_expr = convert_implicitly(std::move(resolved_expr), var->type);
+    if (!is_assignable(resolved_expr->type, var->type)) {
         push_exception("Expression type does not match variable type", assignment.loc);
         return nullptr;
     }
@@ -311,9 +578,15 @@ std::unique_ptr<ResolvedAssignment> Sema::resolve_assignment(const AssignmentAST
         push_exception("Variable '" + var->name + "' is immutable and cannot be mutated", assignment.loc);
         return nullptr;
     }
+    if (assignment.op != TokenType::ASSIGN &&
+        !check_operands(assignment.op, var->type, *resolved_expr, options.overflow, assignment.loc)) {
+        return nullptr;
+    }
 
-    return std::make_unique<ResolvedAssignment>(assignment.loc, std::move(resolved_variable), assignment.op,
-                                                std::move(resolved_expr));
+    auto resolved_assignment = std::make_unique<ResolvedAssignment>(assignment.loc, std::move(resolved_variable),
+                                                                    assignment.op, std::move(resolved_expr));
+    resolved_assignment->overflow = options.overflow;
+    return resolved_assignment;
 }
 
 std::unique_ptr<ResolvedWhile> Sema::resolve_while(const WhileAST& while_loop) {
@@ -324,14 +597,162 @@ std::unique_ptr<ResolvedWhile> Sema::resolve_while(const WhileAST& while_loop) {
         return nullptr;
     }
 
-    HANDLE_MAKE_VAR(resolved_body, resolve_block(*while_loop.body))
+    auto hints = resolve_loop_hints(while_loop.attributes);
+    if (!hints) {
+        return nullptr;
+    }
+
+    HANDLE_MAKE_VAR(resolved_body, resolve_loop_body(*while_loop.body))
+
+    current_function->has_loops = true;
+    auto resolved_while =
+        std::make_unique<ResolvedWhile>(while_loop.loc, std::move(condition), std::move(resolved_body));
+    resolved_while->hints = *hints;
+    return resolved_while;
+}
+
+std::unique_ptr<ResolvedBlock> Sema::resolve_loop_body(const BlockAST& body) {
+    loop_depth++;
+    auto resolved_body = resolve_block(body);
+    loop_depth--;
+    return resolved_body;
+}
+
+std::optional<LoopHints> Sema::resolve_loop_hints(const std::vector<AttributeAST>& attributes) {
+    LoopHints hints;
+    std::set<std::string> seen;
+
+    for (const auto& attribute : attributes) {
+        const std::string& name = attribute.name;
+        if (!seen.insert(name).second) {
+            push_exception("Duplicate loop attribute '@" + name + "'", attribute.loc);
+            return std::nullopt;
+        }
+        if (attribute.arguments.size() > 1) {
+            push_exception("Attribute '@" + name + "' takes at most one argument", attribute.loc);
+            return std::nullopt;
+        }
+
+        // Arguments are a count or one of the words `disable` and `full`
+        bool has_argument = !attribute.arguments.empty();
+        uint64_t count = 0;
+        std::string word;
+        if (has_argument) {
+            const ExprAST* argument = attribute.arguments[0].get();
+            if (const auto* literal = dynamic_cast<const PrimitiveAST*>(argument);
+                literal && literal->type == TokenType::INT64) {
+                // Counts end up as i32 operands of the loop metadata
+                std::optional<uint64_t> value = parse_integer(literal->value);
+                if (!value || *value > UINT32_MAX) {
+                    push_exception("Count for '@" + name + "' must be at most " + std::to_string(UINT32_MAX),
+                                   literal->loc);
+                    return std::nullopt;
+                }
+                count = *value;
+            } else if (const auto* variable = dynamic_cast<const VariableAST*>(argument)) {
+                word = variable->name;
+            }
+        }
+
+        bool valid = false;
+        if (name == "unroll") {
+            valid = !has_argument || count > 0 || word == "disable" || word == "full";
+            hints.unroll = word != "disable";
+            hints.unroll_full = word == "full";
+            hints.unroll_count = count;
+        } else if (name == "vectorize") {
+            valid = !has_argument || count > 0 || word == "disable";
+            hints.vectorize = word != "disable";
+            hints.vectorize_width = count;
+        } else if (name == "interleave") {
+            valid = count > 0;
+            hints.interleave_count = count;
+        } else if (name == "distribute") {
+            valid = !has_argument;
+            hints.distribute = true;
+        } else {
+            push_exception("Unknown loop attribute '@" + name + "'", attribute.loc);
+            return std::nullopt;
+        }
+
+        if (!valid) {
+            push_exception("Invalid argument to '@" + name + "'", attribute.loc);
+            return std::nullopt;
+        }
+    }
+
+    return hints;
+}
+
+std::unique_ptr<ResolvedFor> Sema::resolve_for(const ForAST& for_loop) {
+    HANDLE_MAKE_VAR(start, resolve_expr(*for_loop.start))
+    HANDLE_MAKE_VAR(end, resolve_expr(*for_loop.end))
+    std::unique_ptr<ResolvedExpr> step;
+    if (for_loop.step) {
+        step = resolve_expr(*for_loop.step);
+        if (!step) {
+            return nullptr;
+        }
+    }
+
+    const Type& type = start->type;
+    if (type != Type::int64 && type != Type::uint64) {
+        push_exception("Range bounds must be integers, found " + type.name, start->loc);
+        return nullptr;
+    }
+    if (end->type != type) {
+        push_exception("Range end of type " + end->type.name + " does not match start of type " + type.name, end->loc);
+        return nullptr;
+    }
+    if (step && step->type != type) {
+        push_exception("Range step of type " + step->type.name + " does not match start of type " + type.name,
+                       step->loc);
+        return nullptr;
+    }
+
+    // Literal steps are checked here, anything else once before the loop starts
+    bool needs_step_check = false;
+    if (step) {
+        const auto* literal = dynamic_cast<const ResolvedPrimitive*>(step.get());
+        if (literal && (type == Type::int64 ? literal->int64 <= 0 : literal->uint64 == 0)) {
+            push_exception("Range step must be positive", step->loc);
+            return nullptr;
+        }
+        needs_step_check = !literal;
+    }
+
+    ScopeRAII loop_scope{this};
+    auto variable = std::make_unique<ResolvedVarDeclare>(for_loop.loc, for_loop.variable, type, nullptr, false);
+    variable->slot = current_function->num_slots++;
+    add_declaration(*variable);
+
+    const auto* start_literal = dynamic_cast<const ResolvedPrimitive*>(start.get());
+    bool non_negative_start = type == Type::uint64 || (start_literal && start_literal->int64 >= 0);
+    auto hints = resolve_loop_hints(for_loop.attributes);
+    if (!hints) {
+        return nullptr;
+    }
+
+    induction_ranges.push_back({variable.get(), end.get(), non_negative_start});
+    auto resolved_body = resolve_loop_body(*for_loop.body);
+    induction_ranges.pop_back();
+    if (!resolved_body) {
+        return nullptr;
+    }
 
-    return std::make_unique<ResolvedWhile>(while_loop.loc, std::move(condition), std::move(resolved_body));
+    // Unlike `while`, the trip count is known on entry, so this doesn't count towards has_loops
+    current_function->has_traps |= needs_step_check;
+    auto resolved_for = std::make_unique<ResolvedFor>(for_loop.loc, std::move(variable), std::move(start),
+                                                      std::move(end), std::move(step), std::move(resolved_body));
+    resolved_for->needs_step_check = needs_step_check;
+    resolved_for->hints = *hints;
+    return resolved_for;
 }
 
 std::unique_ptr<ResolvedReturn> Sema::resolve_return(const ReturnAST& return_stmt) {
     if (return_stmt.value) {
         HANDLE_MAKE_VAR(resolved_value, resolve_expr(*return_stmt.value));
+        resolved_value = convert_implicitly(std::move(resolved_value), current_function->type);
 
         if (current_function->type == Type::void_ && resolved_value->type != Type::void_) {
             push_exception("Void function '" + current_function->name + "' cannot return a value", resolved_value->loc);
@@ -343,6 +764,7 @@ std::unique_ptr<ResolvedReturn> Sema::resolve_return(const ReturnAST& return_stm
                            resolved_value->loc);
         }
 
+        mark_tail_calls(*resolved_value);
         return std::make_unique<ResolvedReturn>(return_stmt.loc, std::move(resolved_value));
     }
 
@@ -355,6 +777,44 @@ std::unique_ptr<ResolvedReturn> Sema::resolve_return(const ReturnAST& return_stm
     return std::make_unique<ResolvedReturn>(return_stmt.loc, nullptr);
 }
 
+void Sema::mark_tail_calls(ResolvedExpr& expr) {
+    if (auto* call = dynamic_cast<ResolvedCall*>(&expr)) {
+        // The call's value can only be forwarded as-is if it's the same type the function returns
+        if (call->type != current_function->type) {
+            return;
+        }
+
+        // Arrays and slices can point into this function's stack frame (array literals are entry block allocas),
+        // which a tail call frees before the callee reads it, and a `tail` marker promises the callee won't
+        for (const auto& argument : call->arguments) {
+            if (argument->type.is_array_like()) {
+                return;
+            }
+        }
+
+        call->is_tail_call = true;
+        if (call->callee == current_function) {
+            current_function->is_tail_recursive = true;
+        }
+        return;
+    }
+
+    // Tail position carries through both branches of an if-expr and the return value of a block
+    if (auto* if_expr = dynamic_cast<ResolvedIfExpr*>(&expr)) {
+        mark_tail_calls(*if_expr->body);
+        if (if_expr->else_body) {
+            mark_tail_calls(*if_expr->else_body);
+        }
+        return;
+    }
+
+    if (auto* block = dynamic_cast<ResolvedBlock*>(&expr)) {
+        if (block->return_value) {
+            mark_tail_calls(*block->return_value);
+        }
+    }
+}
+
 std::unique_ptr<ResolvedFunction> Sema::resolve_function(const FunctionAST& function) {
     std::optional<Type> return_type = resolve_type(function.type);
 
@@ -364,6 +824,12 @@ std::unique_ptr<ResolvedFunction> Sema::resolve_function(const FunctionAST& func
         return nullptr;
     }
 
+    // Array literals live in their function's stack frame, so they can't outlive it
+    if (return_type->is_array_like()) {
+        push_exception("Function '" + function.name + "' cannot return an array or slice", function.loc);
+        return nullptr;
+    }
+
     if (function.name == "main") {
         if (return_type->ty != Ty::VOID) {
             push_exception("Function 'main' must return void", function.loc);
@@ -385,11 +851,61 @@ std::unique_ptr<ResolvedFunction> Sema::resolve_function(const FunctionAST& func
         if (!add_declaration(*resolved_param)) {
             return nullptr;
         }
+        resolved_param->slot = resolved_params.size();
         resolved_params.push_back(std::move(resolved_param));
     }
 
-    return std::make_unique<ResolvedFunction>(function.loc, function.name, std::move(resolved_params), *return_type,
-                                              nullptr);
+    size_t num_params = resolved_params.size();
+    auto resolved_function = std::make_unique<ResolvedFunction>(function.loc, function.name, std::move(resolved_params),
+                                                                *return_type, nullptr);
+    resolved_function->num_slots = num_params;
+    resolved_function->is_exported = function.is_exported || function.name == "main";
+    resolved_function->float_model = options.float_model;
+    if (!resolve_function_attributes(function.attributes, *resolved_function)) {
+        return nullptr;
+    }
+    return resolved_function;
+}
+
+bool Sema::resolve_function_attributes(const std::vector<AttributeAST>& attributes, ResolvedFunction& function) {
+    for (const auto& attribute : attributes) {
+        const std::string& name = attribute.name;
+
+        // Arguments are single words, like the `fast` in @fp_contract(fast)
+        std::string word;
+        if (attribute.arguments.size() == 1) {
+            if (const auto* variable = dynamic_cast<const VariableAST*>(attribute.arguments[0].get())) {
+                word = variable->name;
+            }
+        }
+
+        bool valid = false;
+        if (name == "fastmath") {
+            valid = attribute.arguments.empty();
+            function.float_model.fast_math = true;
+        } else if (name == "fp_contract") {
+            std::optional<FpContract> contract = parse_fp_contract(word);
+            valid = contract.has_value();
+            function.float_model.contract = contract.value_or(FpContract::OFF);
+        } else if (name == "hot" || name == "cold") {
+            valid = attribute.arguments.empty();
+            function.is_hot |= name == "hot";
+            function.is_cold |= name == "cold";
+            if (function.is_hot && function.is_cold) {
+                push_exception("Function '" + function.name + "' cannot be both hot and cold", attribute.loc);
+                return false;
+            }
+        } else {
+            push_exception("Unknown function attribute '@" + name + "'", attribute.loc);
+            return false;
+        }
+
+        if (!valid) {
+            push_exception("Invalid argument to '@" + name + "'", attribute.loc);
+            return false;
+        }
+    }
+    return true;
 }
 
 std::unique_ptr<ResolvedParamDeclare> Sema::resolve_param_decl(const ParamDeclareAST& param) {
@@ -425,17 +941,48 @@ std::unique_ptr<ResolvedVarDeclare> Sema::resolve_var_decl(const VarDeclareAST&
         return nullptr;
     }
 
-    if (resolved_expr && resolved_expr->type != resolved_type) {
+    if (resolved_expr) {
+        resolved_expr = convert_implicitly(std::move(resolved_expr), *resolved_type);
+    }
+    if (resolved_expr && !is_assignable(resolved_expr->type, *resolved_type)) {
         push_exception("Variable '" + var_decl.name + "' type declaration does not match initializer expression type",
                        var_decl.loc);
     }
 
-    return std::make_unique<ResolvedVarDeclare>(var_decl.loc, var_decl.name, *resolved_type, std::move(resolved_expr),
-                                                var_decl.is_mutable);
+    auto resolved_var_decl = std::make_unique<ResolvedVarDeclare>(var_decl.loc, var_decl.name, *resolved_type,
+                                                                  std::move(resolved_expr), var_decl.is_mutable);
+    resolved_var_decl->slot = current_function->num_slots++;
+    return resolved_var_decl;
 }
 
-std::unique_ptr<ResolvedCall> Sema::resolve_call(const CallAST& call) {
+std::unique_ptr<ResolvedExpr> Sema::resolve_call(const CallAST& call) {
     const auto& [resolved_decl, scope_level] = lookup_declaration(call.callee);
+    if (!resolved_decl && call.callee == "len") {
+        return resolve_len(call);
+    }
+
+    static const std::map<std::string, VectorOp> vector_ops{
+        {"shuffle", VectorOp::SHUFFLE},       {"select", VectorOp::SELECT},
+        {"extract", VectorOp::EXTRACT},       {"insert", VectorOp::INSERT},
+        {"reduce_add", VectorOp::REDUCE_ADD}, {"reduce_mul", VectorOp::REDUCE_MUL},
+        {"reduce_min", VectorOp::REDUCE_MIN}, {"reduce_max", VectorOp::REDUCE_MAX},
+        {"reduce_any", VectorOp::REDUCE_ANY}, {"reduce_all", VectorOp::REDUCE_ALL}};
+    if (auto vector_op = vector_ops.find(call.callee); !resolved_decl && vector_op != vector_ops.end()) {
+        return resolve_vector_op(call, vector_op->second);
+    }
+
+    static const std::map<std::string, IntrinsicOp> intrinsics{
+        {"sqrt", IntrinsicOp::SQRT},         {"sin", IntrinsicOp::SIN},     {"cos", IntrinsicOp::COS},
+        {"exp", IntrinsicOp::EXP},           {"exp2", IntrinsicOp::EXP2},   {"log", IntrinsicOp::LOG},
+        {"log2", IntrinsicOp::LOG2},         {"log10", IntrinsicOp::LOG10}, {"floor", IntrinsicOp::FLOOR},
+        {"ceil", IntrinsicOp::CEIL},         {"trunc", IntrinsicOp::TRUNC}, {"round", IntrinsicOp::ROUND},
+        {"fma", IntrinsicOp::FMA},           {"copysign", IntrinsicOp::COPYSIGN},
+        {"abs", IntrinsicOp::ABS},           {"min", IntrinsicOp::MIN},     {"max", IntrinsicOp::MAX},
+        {"popcount", IntrinsicOp::POPCOUNT}, {"clz", IntrinsicOp::CLZ},     {"ctz", IntrinsicOp::CTZ},
+        {"bswap", IntrinsicOp::BSWAP},       {"rotl", IntrinsicOp::ROTL},   {"rotr", IntrinsicOp::ROTR}};
+    if (auto intrinsic = intrinsics.find(call.callee); !resolved_decl && intrinsic != intrinsics.end()) {
+        return resolve_intrinsic(call, intrinsic->second);
+    }
     if (!resolved_decl) {
         push_exception("Cannot find function '" + call.callee + "'", call.loc);
         return nullptr;
@@ -463,8 +1010,9 @@ std::unique_ptr<ResolvedCall> Sema::resolve_call(const CallAST& call) {
         const auto& argument = call.arguments[i];
 
         HANDLE_MAKE_VAR(resolved_expr, resolve_expr(*argument))
+        resolved_expr = convert_implicitly(std::move(resolved_expr), resolved_function->parameters[i]->type);
         // TODO: Check against more complex types (E.g functions and classes)
-        if (resolved_expr->type.ty != resolved_function->parameters[i]->type.ty) {
+        if (!is_assignable(resolved_expr->type, resolved_function->parameters[i]->type)) {
             push_exception("Argument and parameter types do not match; expected " +
                                resolved_function->parameters[i]->type.name + ", found " + resolved_expr->type.name,
                            call.loc);
@@ -474,9 +1022,513 @@ std::unique_ptr<ResolvedCall> Sema::resolve_call(const CallAST& call) {
         resolved_arguments.emplace_back(std::move(resolved_expr));
     }
 
+    current_function->callees.push_back(resolved_function);
     return std::make_unique<ResolvedCall>(call.loc, *resolved_function, std::move(resolved_arguments));
 }
 
+std::unique_ptr<ResolvedLen> Sema::resolve_len(const CallAST& call) {
+    if (call.arguments.size() != 1) {
+        push_exception("Expected 1 argument in call to 'len', got " + std::to_string(call.arguments.size()), call.loc);
+        return nullptr;
+    }
+
+    HANDLE_MAKE_VAR(resolved_expr, resolve_expr(*call.arguments[0]))
+    if (!resolved_expr->type.is_array_like() && resolved_expr->type != Type::string) {
+        push_exception("'len' expects a string, array or slice, found " + resolved_expr->type.name, call.loc);
+        return nullptr;
+    }
+
+    return std::make_unique<ResolvedLen>(call.loc, std::move(resolved_expr));
+}
+
+std::unique_ptr<ResolvedExpr> Sema::resolve_construct(const ConstructAST& construct) {
+    const Type& type = construct.type;
+    const Type& scalar_type = type.is_vector() ? *type.element : type;
+    if (!type.is_vector() && !type.is_numeric()) {
+        push_exception("Cannot construct a value of type " + type.name, construct.loc);
+        return nullptr;
+    }
+
+    size_t num_arguments = construct.arguments.size();
+    if (!type.is_vector() && num_arguments != 1) {
+        push_exception(type.name + " takes 1 argument, got " + std::to_string(num_arguments), construct.loc);
+        return nullptr;
+    }
+
+    // Conversions: int32(x), float64(n), or float32x8(v) from another vector with as many lanes
+    if (num_arguments == 1 && scalar_type.is_numeric()) {
+        HANDLE_MAKE_VAR(value, resolve_expr(*construct.arguments[0]))
+        value = convert_implicitly(std::move(value), type);
+        if (value->type == type) {
+            return value;
+        }
+
+        const Type& from = value->type;
+        bool lanes_match = type.is_vector() ? from.is_vector() && from.length == type.length : !from.is_vector();
+        const Type& from_scalar = from.is_vector() ? *from.element : from;
+        if (lanes_match && (from_scalar.is_numeric() || from_scalar == Type::boolean)) {
+            return std::make_unique<ResolvedCast>(construct.loc, type, std::move(value));
+        }
+        if (!type.is_vector()) {
+            push_exception("Cannot convert a value of type " + from.name + " to " + type.name, construct.loc);
+            return nullptr;
+        }
+
+        // Otherwise it's a splat; from here on that value is the only lane
+        std::vector<std::unique_ptr<ResolvedExpr>> elements;
+        value = convert_implicitly(std::move(value), scalar_type);
+        if (value->type != scalar_type) {
+            push_exception("Lanes of " + type.name + " must be " + scalar_type.name + ", found " + value->type.name,
+                           value->loc);
+            return nullptr;
+        }
+        elements.push_back(std::move(value));
+        return std::make_unique<ResolvedVectorLiteral>(construct.loc, type, std::move(elements));
+    }
+
+    if (num_arguments != 1 && num_arguments != type.length) {
+        push_exception(type.name + " takes 1 or " + std::to_string(type.length) + " lanes, got " +
+                           std::to_string(num_arguments),
+                       construct.loc);
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<ResolvedExpr>> elements;
+    for (auto&& argument : construct.arguments) {
+        HANDLE_MAKE_VAR(element, resolve_expr(*argument))
+        element = convert_implicitly(std::move(element), *type.element);
+        if (element->type != *type.element) {
+            push_exception("Lanes of " + type.name + " must be " + type.element->name + ", found " + element->type.name,
+                           element->loc);
+            return nullptr;
+        }
+        elements.push_back(std::move(element));
+    }
+
+    return std::make_unique<ResolvedVectorLiteral>(construct.loc, type, std::move(elements));
+}
+
+std::optional<int> Sema::resolve_lane(const ExprAST& lane, uint64_t num_lanes) {
+    const auto* literal = dynamic_cast<const PrimitiveAST*>(&lane);
+    if (!literal || literal->type != TokenType::INT64) {
+        push_exception("Lane must be an integer literal", lane.loc);
+        return std::nullopt;
+    }
+
+    std::optional<uint64_t> index = parse_integer(literal->value);
+    if (!index || *index >= num_lanes) {
+        push_exception("Lane " + literal->value + " is out of range for " + std::to_string(num_lanes) + " lanes",
+                       lane.loc);
+        return std::nullopt;
+    }
+    return static_cast<int>(*index);
+}
+
+std::unique_ptr<ResolvedIntrinsic> Sema::resolve_intrinsic(const CallAST& call, IntrinsicOp op) {
+    size_t expected_num_args = 1;
+    if (op == IntrinsicOp::FMA) {
+        expected_num_args = 3;
+    } else if (op == IntrinsicOp::COPYSIGN || op == IntrinsicOp::MIN || op == IntrinsicOp::MAX ||
+               op == IntrinsicOp::ROTL || op == IntrinsicOp::ROTR) {
+        expected_num_args = 2;
+    }
+    if (call.arguments.size() != expected_num_args) {
+        push_exception("Expected " + std::to_string(expected_num_args) + " argument" +
+                           (expected_num_args != 1 ? "s " : " ") + "in call to '" + call.callee + "', got " +
+                           std::to_string(call.arguments.size()),
+                       call.loc);
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<ResolvedExpr>> operands;
+    for (const auto& argument : call.arguments) {
+        HANDLE_MAKE_VAR(operand, resolve_expr(*argument))
+        operands.push_back(std::move(operand));
+    }
+
+    // The arguments share the type of the first one that isn't an untyped literal, so min(x, 0) works for any scalar x.
+    // Untyped integer literals stand in for floats here too, which they don't do anywhere else
+    auto typed = std::find_if(operands.begin(), operands.end(), [](const auto& operand) {
+        const auto* literal = dynamic_cast<const ResolvedPrimitive*>(operand.get());
+        return !literal || !literal->is_untyped;
+    });
+    Type type = (typed != operands.end() ? *typed : operands[0])->type;
+    for (auto& operand : operands) {
+        auto* literal = dynamic_cast<ResolvedPrimitive*>(operand.get());
+        if (literal && literal->is_untyped && literal->type.is_integer() && type.is_float()) {
+            literal->float64 = static_cast<double>(literal->int64);
+            literal->type = Type::float64;
+        }
+        operand = convert_implicitly(std::move(operand), type);
+        if (operand->type != type) {
+            push_exception("Arguments to '" + call.callee + "' must have the same type, found " + type.name +
+                               " and " + operand->type.name,
+                           operand->loc);
+            return nullptr;
+        }
+    }
+
+    const Type& scalar_type = type.is_vector() ? *type.element : type;
+    bool is_bit_op = op == IntrinsicOp::POPCOUNT || op == IntrinsicOp::CLZ || op == IntrinsicOp::CTZ ||
+                     op == IntrinsicOp::BSWAP || op == IntrinsicOp::ROTL || op == IntrinsicOp::ROTR;
+    bool takes_integers = is_bit_op || op == IntrinsicOp::ABS || op == IntrinsicOp::MIN || op == IntrinsicOp::MAX;
+    if (!(scalar_type.is_float() && !is_bit_op) && !(scalar_type.is_integer() && takes_integers)) {
+        std::string expected = is_bit_op ? "integer" : takes_integers ? "numeric" : "float";
+        push_exception("'" + call.callee + "' expects " + expected + " arguments, found " + type.name, call.loc);
+        return nullptr;
+    }
+    if (op == IntrinsicOp::BSWAP && scalar_type.bit_width() < 16) {
+        push_exception("'bswap' needs at least 16 bits, found " + type.name, call.loc);
+        return nullptr;
+    }
+
+    return std::make_unique<ResolvedIntrinsic>(call.loc, type, op, std::move(operands));
+}
+
+std::unique_ptr<ResolvedVectorOp> Sema::resolve_vector_op(const CallAST& call, VectorOp op) {
+    const auto& arguments = call.arguments;
+    if (arguments.empty()) {
+        push_exception("'" + call.callee + "' expects a vector argument", call.loc);
+        return nullptr;
+    }
+
+    HANDLE_MAKE_VAR(vector, resolve_expr(*arguments[0]))
+    const Type vector_type = vector->type;
+    bool is_mask_op = op == VectorOp::REDUCE_ANY || op == VectorOp::REDUCE_ALL;
+    // select's first argument is the mask, which may also be a plain bool for a scalar select
+    if (!vector_type.is_vector() && op != VectorOp::SELECT) {
+        push_exception("'" + call.callee + "' expects a vector, found " + vector_type.name, vector->loc);
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<ResolvedExpr>> operands;
+    operands.push_back(std::move(vector));
+    std::vector<int> lanes;
+
+    auto expect_arguments = [&](size_t expected) {
+        if (arguments.size() != expected) {
+            push_exception("Expected " + std::to_string(expected) + " arguments in call to '" + call.callee +
+                               "', got " + std::to_string(arguments.size()),
+                           call.loc);
+            return false;
+        }
+        return true;
+    };
+
+    Type type = vector_type.is_vector() ? *vector_type.element : vector_type;
+    switch (op) {
+        case VectorOp::SHUFFLE: {
+            // A second vector of the same type extends the lanes to pick from
+            size_t first_lane = 1;
+            if (arguments.size() > 1) {
+                const auto* literal = dynamic_cast<const PrimitiveAST*>(arguments[1].get());
+                if (!literal || literal->type != TokenType::INT64) {
+                    HANDLE_MAKE_VAR(second, resolve_expr(*arguments[1]))
+                    if (second->type != vector_type) {
+                        push_exception("Shuffled vectors must have the same type", second->loc);
+                        return nullptr;
+                    }
+                    operands.push_back(std::move(second));
+                    first_lane = 2;
+                }
+            }
+
+            uint64_t num_lanes = vector_type.length * operands.size();
+            for (size_t i = first_lane; i < arguments.size(); i++) {
+                std::optional<int> lane = resolve_lane(*arguments[i], num_lanes);
+                if (!lane) {
+                    return nullptr;
+                }
+                lanes.push_back(*lane);
+            }
+            if (lanes.size() < 2) {
+                push_exception("'shuffle' needs at least 2 lanes", call.loc);
+                return nullptr;
+            }
+            type = Type::vector(*vector_type.element, lanes.size());
+            break;
+        }
+        case VectorOp::SELECT: {
+            if (!expect_arguments(3)) {
+                return nullptr;
+            }
+            HANDLE_MAKE_VAR(if_true, resolve_expr(*arguments[1]))
+            HANDLE_MAKE_VAR(if_false, resolve_expr(*arguments[2]))
+            if_false = convert_implicitly(std::move(if_false), if_true->type);
+            if_true = convert_implicitly(std::move(if_true), if_false->type);
+
+            if (if_true->type == Type::void_ || if_false->type == Type::void_) {
+                push_exception("'select' needs two values to choose between, found void", call.loc);
+                return nullptr;
+            }
+
+            const Type& mask_type = operands[0]->type;
+            bool valid_mask = mask_type == Type::boolean ||
+                              (mask_type.is_vector() && *mask_type.element == Type::boolean &&
+                               if_true->type.is_vector() && if_true->type.length == mask_type.length);
+            if (!valid_mask || if_true->type != if_false->type) {
+                push_exception("'select' expects a mask and two values of the same type with as many lanes", call.loc);
+                return nullptr;
+            }
+            type = if_true->type;
+            operands.push_back(std::move(if_true));
+            operands.push_back(std::move(if_false));
+            break;
+        }
+        case VectorOp::EXTRACT: {
+            if (!expect_arguments(2)) {
+                return nullptr;
+            }
+            std::optional<int> lane = resolve_lane(*arguments[1], vector_type.length);
+            if (!lane) {
+                return nullptr;
+            }
+            lanes.push_back(*lane);
+            break;
+        }
+        case VectorOp::INSERT: {
+            if (!expect_arguments(3)) {
+                return nullptr;
+            }
+            std::optional<int> lane = resolve_lane(*arguments[1], vector_type.length);
+            HANDLE_MAKE_VAR(value, resolve_expr(*arguments[2]))
+            if (!lane) {
+                return nullptr;
+            }
+            value = convert_implicitly(std::move(value), *vector_type.element);
+            if (value->type != *vector_type.element) {
+                push_exception("Inserted value must be " + vector_type.element->name + ", found " + value->type.name,
+                               value->loc);
+                return nullptr;
+            }
+            lanes.push_back(*lane);
+            operands.push_back(std::move(value));
+            type = vector_type;
+            break;
+        }
+        default: {
+            if (!expect_arguments(1)) {
+                return nullptr;
+            }
+            bool is_mask = *vector_type.element == Type::boolean;
+            if (is_mask != is_mask_op) {
+                push_exception("'" + call.callee + "' expects " + (is_mask_op ? "a mask" : "a numeric vector") +
+                                   ", found " + vector_type.name,
+                               call.loc);
+                return nullptr;
+            }
+            break;
+        }
+    }
+
+    return std::make_unique<ResolvedVectorOp>(call.loc, type, op, std::move(operands), std::move(lanes));
+}
+
+std::unique_ptr<ResolvedArrayLiteral> Sema::resolve_array_literal(const ArrayLiteralAST& array_literal) {
+    if (array_literal.elements.empty()) {
+        push_exception("Empty array literals have no element type", array_literal.loc);
+        return nullptr;
+    }
+
+    std::vector<std::unique_ptr<ResolvedExpr>> resolved_elements;
+    for (auto&& element : array_literal.elements) {
+        HANDLE_MAKE_VAR(resolved_element, resolve_expr(*element))
+
+        if (resolved_element->type == Type::void_) {
+            push_exception("Array elements cannot be void", resolved_element->loc);
+            return nullptr;
+        }
+        if (!resolved_elements.empty()) {
+            resolved_element = convert_implicitly(std::move(resolved_element), resolved_elements[0]->type);
+        }
+        if (!resolved_elements.empty() && resolved_element->type != resolved_elements[0]->type) {
+            push_exception("Array element of type " + resolved_element->type.name +
+                               " does not match the first element's type of " + resolved_elements[0]->type.name,
+                           resolved_element->loc);
+            return nullptr;
+        }
+
+        resolved_elements.push_back(std::move(resolved_element));
+    }
+
+    uint64_t length = array_literal.repeat_count.value_or(resolved_elements.size());
+    Type type = Type::array(resolved_elements[0]->type, length);
+    return std::make_unique<ResolvedArrayLiteral>(array_literal.loc, std::move(type), std::move(resolved_elements),
+                                                  array_literal.repeat_count.has_value());
+}
+
+std::unique_ptr<ResolvedIndex> Sema::resolve_index_expr(const IndexExprAST& index_expr) {
+    HANDLE_MAKE_VAR(resolved_base, resolve_expr(*index_expr.base))
+    HANDLE_MAKE_VAR(resolved_index, resolve_expr(*index_expr.index))
+
+    const Type& base_type = resolved_base->type;
+    if (!base_type.is_array_like() && base_type != Type::string) {
+        push_exception("Cannot index into a value of type " + base_type.name, index_expr.loc);
+        return nullptr;
+    }
+    if (!resolved_index->type.is_integer()) {
+        push_exception("Index must be an integer, found " + resolved_index->type.name, resolved_index->loc);
+        return nullptr;
+    }
+    if (resolved_index->type != Type::uint64) {
+        resolved_index = convert_implicitly(std::move(resolved_index), Type::int64);
+    }
+
+    // Strings index to their bytes
+    Type element_type = base_type == Type::string ? Type::int64 : *base_type.element;
+    auto resolved_index_expr = std::make_unique<ResolvedIndex>(index_expr.loc, element_type,
+                                                               std::move(resolved_base), std::move(resolved_index));
+
+    // Literal indices into fixed size arrays are checked right here instead of at runtime
+    const auto* literal = dynamic_cast<const ResolvedPrimitive*>(resolved_index_expr->index.get());
+    if (literal && base_type.ty == Ty::ARRAY) {
+        // Negative indices wrap around to huge unsigned ones
+        if (static_cast<uint64_t>(literal->int64) >= base_type.length) {
+            push_exception("Index " + std::to_string(literal->int64) + " is out of bounds for " + base_type.name,
+                           literal->loc);
+            return nullptr;
+        }
+        resolved_index_expr->needs_bounds_check = false;
+    } else if (is_induction_in_bounds(*resolved_index_expr->base, *resolved_index_expr->index)) {
+        resolved_index_expr->needs_bounds_check = false;
+    }
+
+    current_function->has_memory_accesses = true;
+    current_function->has_traps |= resolved_index_expr->needs_bounds_check;
+    return resolved_index_expr;
+}
+
+std::unique_ptr<ResolvedIndexAssignment> Sema::resolve_index_assignment(const IndexAssignmentAST& assignment) {
+    HANDLE_MAKE_VAR(resolved_target, resolve_index_expr(*assignment.target))
+    HANDLE_MAKE_VAR(resolved_expr, resolve_expr(*assignment.expr))
+
+    if (resolved_target->base->type == Type::string) {
+        push_exception("Strings are immutable and cannot be assigned to", assignment.loc);
+        return nullptr;
+    }
+
+    // Elements follow the mutability of the binding that owns them. Parameters and slices are views of someone else's
+    // array, which may well be a `let`, so they're read only
+    const auto* base_variable = dynamic_cast<const ResolvedVariable*>(resolved_target->base.get());
+    const auto* var_decl = base_variable ? dynamic_cast<const ResolvedVarDeclare*>(base_variable->declaration) : nullptr;
+    if (base_variable && !var_decl) {
+        push_exception("Parameter '" + base_variable->declaration->name +
+                           "' is immutable and its elements cannot be assigned to",
+                       assignment.loc);
+        return nullptr;
+    }
+    if (var_decl && !var_decl->is_mutable) {
+        push_exception("Variable '" + var_decl->name + "' is immutable and its elements cannot be assigned to",
+                       assignment.loc);
+        return nullptr;
+    }
+    if (!var_decl || resolved_target->base->type.ty != Ty::ARRAY) {
+        push_exception("Only elements of 'mut' arrays can be assigned to, found " + resolved_target->base->type.name,
+                       assignment.loc);
+        return nullptr;
+    }
+    resolved_expr = convert_implicitly(std::move(resolved_expr), resolved_target->type);
+    if (!is_assignable(resolved_expr->type, resolved_target->type)) {
+        push_exception("Expression of type " + resolved_expr->type.name + " cannot be assigned to an element of type " +
+                           resolved_target->type.name,
+                       assignment.loc);
+        return nullptr;
+    }
+    bool is_bitwise = assignment.op == TokenType::BITWISE_AND || assignment.op == TokenType::BITWISE_OR ||
+                      assignment.op == TokenType::BITWISE_XOR;
+    if (assignment.op != TokenType::ASSIGN && !resolved_target->type.is_numeric() && !is_bitwise) {
+        push_exception("Compound assignment needs a numeric element type, found " + resolved_target->type.name,
+                       assignment.loc);
+        return nullptr;
+    }
+    if (assignment.op != TokenType::ASSIGN &&
+        !check_operands(assignment.op, resolved_target->type, *resolved_expr, options.overflow, assignment.loc)) {
+        return nullptr;
+    }
+
+    auto resolved_assignment = std::make_unique<ResolvedIndexAssignment>(assignment.loc, std::move(resolved_target),
+                                                                         assignment.op, std::move(resolved_expr));
+    resolved_assignment->overflow = options.overflow;
+    return resolved_assignment;
+}
+
+// True for x[i] inside `for i in 0..len(x)` (or `0..N` over a [T; M] with N <= M), which never goes out of bounds as
+// long as x can't be reassigned inside the loop
+bool Sema::is_induction_in_bounds(const ResolvedExpr& base, const ResolvedExpr& index) {
+    const auto* index_variable = dynamic_cast<const ResolvedVariable*>(&index);
+    if (!index_variable) {
+        return false;
+    }
+
+    auto range = std::find_if(induction_ranges.begin(), induction_ranges.end(), [&](const InductionRange& range) {
+        return range.variable == index_variable->declaration;
+    });
+    if (range == induction_ranges.end() || !range->non_negative_start) {
+        return false;
+    }
+
+    if (const auto* end_literal = dynamic_cast<const ResolvedPrimitive*>(range->end); end_literal) {
+        bool negative = end_literal->type == Type::int64 && end_literal->int64 < 0;
+        return base.type.ty == Ty::ARRAY && !negative && end_literal->uint64 <= base.type.length;
+    }
+
+    const auto* len = dynamic_cast<const ResolvedLen*>(range->end);
+    const auto* base_variable = dynamic_cast<const ResolvedVariable*>(&base);
+    if (!len || !base_variable) {
+        return false;
+    }
+    const auto* len_variable = dynamic_cast<const ResolvedVariable*>(len->expr.get());
+    if (!len_variable || len_variable->declaration != base_variable->declaration) {
+        return false;
+    }
+
+    // An array's length is part of its type, so only slices and strings have to stay put
+    const auto* var_decl = dynamic_cast<const ResolvedVarDeclare*>(base_variable->declaration);
+    return base.type.ty == Ty::ARRAY || !var_decl || !var_decl->is_mutable;
+}
+
+bool Sema::is_assignable(const Type& from, const Type& to) {
+    // Arrays are already {ptr, len}, so they can be passed anywhere a slice of the same element type is expected
+    if (from.ty == Ty::ARRAY && to.ty == Ty::SLICE) {
+        return *from.element == *to.element;
+    }
+    return from == to;
+}
+
+// Conversions that never lose information: to a wider integer of the same signedness, from unsigned to a wider signed
+// integer, and from float32 to float64
+bool Sema::is_widening(const Type& from, const Type& to) {
+    if (from.is_integer() && to.is_integer()) {
+        bool same_signedness = from.is_signed_integer() == to.is_signed_integer();
+        return to.bit_width() > from.bit_width() && (same_signedness || to.is_signed_integer());
+    }
+    return from == Type::float32 && to == Type::float64;
+}
+
+// Untyped literals take on the type they're used as if their value fits, and narrower numbers widen to wider ones.
+// Anything else is left alone for the caller to report, and needs an explicit T(x)
+std::unique_ptr<ResolvedExpr> Sema::convert_implicitly(std::unique_ptr<ResolvedExpr> expr, const Type& to) {
+    if (expr->type == to) {
+        return expr;
+    }
+
+    auto* literal = dynamic_cast<ResolvedPrimitive*>(expr.get());
+    if (literal && literal->is_untyped) {
+        bool fits = expr->type.is_integer() ? to.is_integer() && fits_integer_type(literal->int64, to)
+                                            : to.is_float();
+        if (fits) {
+            literal->type = to;
+            return expr;
+        }
+    }
+
+    if (is_widening(expr->type, to)) {
+        SourceLocation loc = expr->loc;
+        return std::make_unique<ResolvedCast>(loc, to, std::move(expr));
+    }
+    return expr;
+}
+
 std::unique_ptr<ResolvedBlock> Sema::resolve_block(const BlockAST& block) {
     std::vector<std::unique_ptr<ResolvedStmt>> resolved_statements;
     bool error = false;
@@ -507,15 +1559,24 @@ std::optional<Type> Sema::resolve_type(Type parsed_type) {
     if (parsed_type.ty == Ty::USER) {
         return std::nullopt;
     }
+
+    if (parsed_type.is_array_like()) {
+        std::optional<Type> element = resolve_type(*parsed_type.element);
+        if (!element || element->ty == Ty::VOID) {
+            return std::nullopt;
+        }
+    }
     return parsed_type;
 }
 
 void Sema::generate_std_function(std::vector<std::unique_ptr<ResolvedStmt>>& std_resolved_ast, const std::string& name,
-                                 const std::vector<std::pair<std::string, Type>>& params, const Type& return_type) {
+                                 const std::vector<std::pair<std::string, Type>>& params, const Type& return_type,
+                                 FunctionEffects effects) {
     auto loc = SourceLocation{0, 0, 0};
     std::vector<std::unique_ptr<ResolvedParamDeclare>> resolved_params;
     for (const auto& [name, type] : params) {
         auto param = std::make_unique<ResolvedParamDeclare>(loc, name, type);
+        param->slot = resolved_params.size();
         resolved_params.push_back(std::move(param));
     }
 
@@ -524,15 +1585,47 @@ void Sema::generate_std_function(std::vector<std::unique_ptr<ResolvedStmt>>& std
                      .emplace_back(std::make_unique<ResolvedFunction>(loc, name, std::move(resolved_params),
                                                                       return_type, std::move(block)))
                      .get();
+    auto* function = dynamic_cast<ResolvedFunction*>(func);
+    function->is_builtin = true;
+    function->num_slots = params.size();
+    function->effects = effects;
     add_declaration(*dynamic_cast<ResolvedDecl*>(func));
 }
 
 std::vector<std::unique_ptr<ResolvedStmt>> Sema::fill_std_functions() {
     std::vector<std::unique_ptr<ResolvedStmt>> std_resolved_ast;
-    generate_std_function(std_resolved_ast, "print", {{"n", Type::int64}}, Type::void_);
-    generate_std_function(std_resolved_ast, "print_char", {{"n", Type::int64}}, Type::void_);
-    generate_std_function(std_resolved_ast, "print_float64", {{"n", Type::float64}}, Type::void_);
-    generate_std_function(std_resolved_ast, "print_string", {{"n", Type::string}}, Type::void_);
+
+    // Printing always returns, but it's I/O and takes stdio's lock
+    FunctionEffects print_effects{true, true, true};
+    generate_std_function(std_resolved_ast, "print", {{"n", Type::int64}}, Type::void_, print_effects);
+    generate_std_function(std_resolved_ast, "print_char", {{"n", Type::int64}}, Type::void_, print_effects);
+    generate_std_function(std_resolved_ast, "print_float64", {{"n", Type::float64}}, Type::void_, print_effects);
+    generate_std_function(std_resolved_ast, "print_string", {{"n", Type::string}}, Type::void_, print_effects);
+    generate_std_function(std_resolved_ast, "flush", {}, Type::void_, print_effects);
+
+    // Formatting only allocates the result, and reading stdin only touches the input buffer. Both are declared
+    // inaccessible memory only by set_runtime_attributes; malloc and stdio still take locks
+    FunctionEffects runtime_effects{false, true, true, true};
+    generate_std_function(std_resolved_ast, "int64_to_string", {{"n", Type::int64}}, Type::string, runtime_effects);
+    generate_std_function(std_resolved_ast, "float64_to_string", {{"n", Type::float64}}, Type::string,
+                          runtime_effects);
+
+    // Reading stdin. input() prints its prompt, so it's the same deal as printing
+    generate_std_function(std_resolved_ast, "read_int64", {}, Type::int64, runtime_effects);
+    generate_std_function(std_resolved_ast, "read_float64", {}, Type::float64, runtime_effects);
+    generate_std_function(std_resolved_ast, "read_token", {}, Type::string, runtime_effects);
+    generate_std_function(std_resolved_ast, "read_line", {}, Type::string, runtime_effects);
+    generate_std_function(std_resolved_ast, "input", {{"prompt", Type::string}}, Type::string, print_effects);
+    generate_std_function(std_resolved_ast, "stdin_eof", {}, Type::boolean, runtime_effects);
+
+    // Files
+    generate_std_function(std_resolved_ast, "read_file", {{"path", Type::string}}, Type::string, print_effects);
+    generate_std_function(std_resolved_ast, "map_file", {{"path", Type::string}}, Type::string, print_effects);
+    generate_std_function(std_resolved_ast, "write_file", {{"path", Type::string}, {"contents", Type::string}},
+                          Type::boolean, print_effects);
+    generate_std_function(std_resolved_ast, "open_reader", {{"path", Type::string}}, Type::int64, print_effects);
+    generate_std_function(std_resolved_ast, "read_chunk", {{"reader", Type::int64}}, Type::string, print_effects);
+    generate_std_function(std_resolved_ast, "close_reader", {{"reader", Type::int64}}, Type::void_, print_effects);
 
     // Raylib
     generate_std_function(std_resolved_ast, "init_window", {{"width", Type::int64}, {"height", Type::int64}},
@@ -577,6 +1670,49 @@ std::vector<std::unique_ptr<ResolvedStmt>> Sema::fill_std_functions() {
     return std_resolved_ast;
 }
 
+void Sema::infer_effects(std::vector<std::unique_ptr<ResolvedStmt>>& resolved_ast) {
+    std::vector<ResolvedFunction*> functions;
+    for (auto& stmt : resolved_ast) {
+        if (auto* function = dynamic_cast<ResolvedFunction*>(stmt.get())) {
+            // Memory and synchronization start optimistic and can only get worse, so recursion can't hide an effect.
+            // will_return starts pessimistic instead: it only holds once every callee is proven to return, which
+            // never happens for recursive functions
+            function->effects = FunctionEffects{false, false, false, false};
+            functions.push_back(function);
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (auto* function : functions) {
+            FunctionEffects effects = function->effects;
+            bool callees_return = !function->has_loops && !function->has_traps;
+            effects.accesses_memory |= function->has_memory_accesses;
+            // A failed check calls a panic_* function, which flushes stdout (taking its lock) and writes to stderr
+            effects.accesses_runtime_state |= function->has_traps;
+            effects.synchronizes |= function->has_traps;
+
+            for (const auto* callee : function->callees) {
+                effects.accesses_memory |= callee->effects.accesses_memory;
+                effects.synchronizes |= callee->effects.synchronizes;
+                effects.accesses_runtime_state |= callee->effects.accesses_runtime_state;
+                callees_return &= callee->effects.will_return;
+            }
+            effects.will_return |= callees_return;
+
+            if (effects.accesses_memory != function->effects.accesses_memory ||
+                effects.synchronizes != function->effects.synchronizes ||
+                effects.will_return != function->effects.will_return ||
+                effects.accesses_runtime_state != function->effects.accesses_runtime_state) {
+                function->effects = effects;
+                changed = true;
+            }
+        }
+    }
+}
+
 std::pair<std::vector<std::unique_ptr<ResolvedStmt>>, std::vector<std::unique_ptr<ResolvedStmt>>> Sema::resolve() {
     std::vector<std::unique_ptr<ResolvedStmt>> resolved_ast;
 
@@ -630,6 +1766,11 @@ std::pair<std::vector<std::unique_ptr<ResolvedStmt>>, std::vector<std::unique_pt
                 continue;
             }
 
+            if (resolved_body->return_value && function->type != Type::void_) {
+                resolved_body->return_value =
+                    convert_implicitly(std::move(resolved_body->return_value), function->type);
+                resolved_body->type = resolved_body->return_value->type;
+            }
             if (resolved_body->return_value) {
                 // TODO: Catch body return value type correctly
                 // E.g currently, if a function ends with a void function but forgets a semicolon, it's incorporated as body's return type, bypassing checks
@@ -642,6 +1783,8 @@ std::pair<std::vector<std::unique_ptr<ResolvedStmt>>, std::vector<std::unique_pt
                                        function->type.name,
                                    resolved_body->loc);
                 }
+
+                mark_tail_calls(*resolved_body->return_value);
             }
 
             current_function->body = std::move(resolved_body);
@@ -652,6 +1795,8 @@ std::pair<std::vector<std::unique_ptr<ResolvedStmt>>, std::vector<std::unique_pt
         return {};
     }
 
+    infer_effects(resolved_ast);
+
     return std::make_pair(std::move(std_resolved_ast), std::move(resolved_ast));
 }
 
@@ -29,17 +29,36 @@ std::string stringify_op(const TokenType& op, bool verbose) {
         {TokenType::POW, {"Power", "**"}},
         {TokenType::BITWISE_AND, {"BitwiseAnd", "&"}},
         {TokenType::BITWISE_OR, {"BitwiseOr", "|"}},
+        {TokenType::BITWISE_XOR, {"BitwiseXor", "^"}},
         {TokenType::BITWISE_NOT, {"BitwiseNot", "~"}},
+        {TokenType::SHIFT_LEFT, {"ShiftLeft", "<<"}},
+        {TokenType::SHIFT_RIGHT, {"ShiftRight", ">>"}},
+        {TokenType::ADD_WRAP, {"WrappingAdd", "+%"}},
+        {TokenType::SUB_WRAP, {"WrappingSubtract", "-%"}},
+        {TokenType::MUL_WRAP, {"WrappingMultiply", "*%"}},
+        {TokenType::ADD_UNCHECKED, {"UncheckedAdd", "+!"}},
+        {TokenType::SUB_UNCHECKED, {"UncheckedSubtract", "-!"}},
+        {TokenType::MUL_UNCHECKED, {"UncheckedMultiply", "*!"}},
+        {TokenType::ADD_CHECKED, {"CheckedAdd", "+?"}},
+        {TokenType::SUB_CHECKED, {"CheckedSubtract", "-?"}},
+        {TokenType::MUL_CHECKED, {"CheckedMultiply", "*?"}},
         {TokenType::GREATER_EQUAL, {"GreaterEqual", ">="}},
         {TokenType::GREATER_THAN, {"GreaterThan", ">"}},
         {TokenType::LESS_EQUAL, {"LessEqual", "<="}},
         {TokenType::LESS_THAN, {"LessThan", "<"}},
         {TokenType::EQUAL, {"Equal", "=="}},
+        {TokenType::NOT_EQUAL, {"NotEqual", "!="}},
         {TokenType::ASSIGN, {"Assign", "="}},
         {TokenType::ADD_ASSIGN, {"AddAssign", "+="}},
         {TokenType::SUB_ASSIGN, {"SubAssign", "-="}},
         {TokenType::MUL_ASSIGN, {"MulAssign", "*="}},
         {TokenType::DIV_ASSIGN, {"DivAssign", "/="}},
+        {TokenType::MOD_ASSIGN, {"ModAssign", "%="}},
+        {TokenType::BITWISE_AND_ASSIGN, {"BitwiseAndAssign", "&="}},
+        {TokenType::BITWISE_OR_ASSIGN, {"BitwiseOrAssign", "|="}},
+        {TokenType::BITWISE_XOR_ASSIGN, {"BitwiseXorAssign", "^="}},
+        {TokenType::SHIFT_LEFT_ASSIGN, {"ShiftLeftAssign", "<<="}},
+        {TokenType::SHIFT_RIGHT_ASSIGN, {"ShiftRightAssign", ">>="}},
         {TokenType::AND, {"And", "And"}},
         {TokenType::OR, {"Or", "Or"}},
         {TokenType::NOT, {"Not", "Not"}}};
@@ -59,9 +78,11 @@ std::string stringify_symbol(const TokenType& symbol, bool verbose) {
         {TokenType::OPEN_BRACES, {"OpenBraces", "{"}},
         {TokenType::CLOSE_BRACES, {"CloseBraces", "}"}},
         {TokenType::DOT, {"Dot", "."}},
+        {TokenType::RANGE, {"Range", ".."}},
         {TokenType::COMMA, {"Comma", ","}},
         {TokenType::COLON, {"Colon", ":"}},
         {TokenType::SEMICOLON, {"Semicolon", ";"}},
+        {TokenType::AT, {"At", "@"}},
         {TokenType::ARROW, {"Arrow", "->"}}};
 
     if (verbose) {
@@ -75,7 +96,8 @@ std::string stringify_keyword(const TokenType& keyword) {
         {TokenType::FUNC, "Func"},    {TokenType::LET, "Let"},   {TokenType::MUT, "Mut"},
         {TokenType::IF, "If"},        {TokenType::ELSE, "Else"}, {TokenType::__OMG, "__OMG"},
         {TokenType::WHILE, "While"},  {TokenType::TRUE, "True"}, {TokenType::FALSE, "False"},
-        {TokenType::RETURN, "Return"}};
+        {TokenType::RETURN, "Return"}, {TokenType::EXPORT, "Export"}, {TokenType::FOR, "For"},
+        {TokenType::IN, "In"}, {TokenType::BREAK, "Break"}, {TokenType::CONTINUE, "Continue"}};
     return token_to_string.at(keyword);
 }
 
@@ -166,8 +188,30 @@ std::string IfExprAST::stringify(size_t indent_level) {
     return string;
 }
 
+std::string AttributeAST::stringify(size_t indent_level) {
+    std::string string{indent_string(indent_level, "Attribute: @" + name)};
+
+    for (auto&& argument : arguments) {
+        string += argument->stringify(indent_level + 1);
+    }
+    return string;
+}
+
+std::string AttributedExprAST::stringify(size_t indent_level) {
+    return attribute.stringify(indent_level);
+}
+
+std::string stringify_attributes(std::vector<AttributeAST>& attributes, size_t indent_level) {
+    std::string string;
+    for (auto&& attribute : attributes) {
+        string += attribute.stringify(indent_level);
+    }
+    return string;
+}
+
 std::string WhileAST::stringify(size_t indent_level) {
     std::string string{indent_string(indent_level, "While Loop:")};
+    string += stringify_attributes(attributes, indent_level + 1);
 
     string += indent_string(indent_level + 1, "Condition:");
     string += condition->stringify(indent_level + 2);
@@ -177,6 +221,32 @@ std::string WhileAST::stringify(size_t indent_level) {
     return string;
 }
 
+std::string ForAST::stringify(size_t indent_level) {
+    std::string string{indent_string(indent_level, "For Loop: " + variable)};
+    string += stringify_attributes(attributes, indent_level + 1);
+
+    string += indent_string(indent_level + 1, "Start:");
+    string += start->stringify(indent_level + 2);
+    string += indent_string(indent_level + 1, "End:");
+    string += end->stringify(indent_level + 2);
+    if (step) {
+        string += indent_string(indent_level + 1, "Step:");
+        string += step->stringify(indent_level + 2);
+    }
+    string += indent_string(indent_level + 1, "Body:");
+    string += body->stringify(indent_level + 2);
+
+    return string;
+}
+
+std::string BreakAST::stringify(size_t indent_level) {
+    return indent_string(indent_level, "Break Statement");
+}
+
+std::string ContinueAST::stringify(size_t indent_level) {
+    return indent_string(indent_level, "Continue Statement");
+}
+
 std::string ReturnAST::stringify(size_t indent_level) {
     std::string string{indent_string(indent_level, "Return Statement")};
 
@@ -190,8 +260,12 @@ std::string ReturnAST::stringify(size_t indent_level) {
 
 std::string FunctionAST::stringify(size_t indent_level) {
     std::string string{indent_string(indent_level, "Function Declaration:")};
+    string += stringify_attributes(attributes, indent_level + 1);
 
     string += indent_string(indent_level + 1, "Name: " + name);
+    if (is_exported) {
+        string += indent_string(indent_level + 1, "Exported: True");
+    }
     string += indent_string(indent_level + 1, "Parameters:");
 
     for (size_t i = 0; i < parameters.size(); i++) {
@@ -286,6 +360,46 @@ std::string AssignmentAST::stringify(size_t indent_level) {
     return string;
 }
 
+std::string IndexAssignmentAST::stringify(size_t indent_level) {
+    std::string string{indent_string(indent_level, "Index Assignment:")};
+
+    string += indent_string(indent_level + 1, "Target: ") + target->stringify(indent_level + 2);
+    if (op != TokenType::ASSIGN) {
+        string += indent_string(indent_level + 1, "Operator: " + stringify_op(op, false));
+    }
+    string += indent_string(indent_level + 1, "Expression: ") + expr->stringify(indent_level + 2);
+
+    return string;
+}
+
+std::string ArrayLiteralAST::stringify(size_t indent_level) {
+    std::string string{indent_string(indent_level, "Array Literal:")};
+
+    if (repeat_count) {
+        string += indent_string(indent_level + 1, "Repeat: " + std::to_string(*repeat_count));
+        string += indent_string(indent_level + 1, "Value:") + elements[0]->stringify(indent_level + 2);
+        return string;
+    }
+
+    for (size_t i = 0; i < elements.size(); i++) {
+        string += indent_string(indent_level + 1, "Element " + std::to_string(i + 1) + ":");
+        string += elements[i]->stringify(indent_level + 2);
+    }
+    if (elements.empty()) {
+        string += indent_string(indent_level + 1, "No Elements");
+    }
+    return string;
+}
+
+std::string IndexExprAST::stringify(size_t indent_level) {
+    std::string string{indent_string(indent_level, "Index:")};
+
+    string += indent_string(indent_level + 1, "Base:") + base->stringify(indent_level + 2);
+    string += indent_string(indent_level + 1, "Index:") + index->stringify(indent_level + 2);
+
+    return string;
+}
+
 std::string CallAST::stringify(size_t indent_level) {
     std::string string{indent_string(indent_level, "Function Call:")};
 
@@ -313,6 +427,16 @@ std::string CallAST::stringify(size_t indent_level) {
     return string;
 }
 
+std::string ConstructAST::stringify(size_t indent_level) {
+    std::string string{indent_string(indent_level, "Construct: " + type.name)};
+
+    for (size_t i = 0; i < arguments.size(); i++) {
+        string += indent_string(indent_level + 1, "Argument " + std::to_string(i + 1) + ":");
+        string += arguments[i]->stringify(indent_level + 2);
+    }
+    return string;
+}
+
 std::string PrimitiveAST::stringify(size_t indent_level) {
     // switch (value_type) {
     //     case ValueType::INT64:
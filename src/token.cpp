@@ -4,17 +4,20 @@
 #include "chung/token.hpp"
 
 bool is_keyword(const std::string& identifier) {
-    static const std::vector<std::string> keyword_identifiers{"func",   "let", "mut",  "__omg",
-                                                              "return", "if",  "else", "while", "true", "false"};
+    static const std::vector<std::string> keyword_identifiers{"func",  "let",      "mut",   "__omg", "return",
+                                                              "if",    "else",     "while", "for",   "in",
+                                                              "break", "continue", "true",  "false", "export"};
 
     return std::find(std::begin(keyword_identifiers), std::end(keyword_identifiers), identifier) !=
            std::end(keyword_identifiers);
 }
 
 bool is_keyword(TokenType keyword) {
-    static const std::vector<TokenType> keywords{TokenType::FUNC,   TokenType::LET,  TokenType::MUT,  TokenType::__OMG,
-                                                 TokenType::RETURN, TokenType::IF,   TokenType::ELSE, TokenType::WHILE,
-                                                 TokenType::TRUE,   TokenType::FALSE};
+    static const std::vector<TokenType> keywords{TokenType::FUNC,   TokenType::LET,   TokenType::MUT,
+                                                 TokenType::__OMG,  TokenType::RETURN, TokenType::IF,
+                                                 TokenType::ELSE,   TokenType::WHILE, TokenType::FOR,
+                                                 TokenType::IN,     TokenType::BREAK, TokenType::CONTINUE,
+                                                 TokenType::TRUE,   TokenType::FALSE, TokenType::EXPORT};
 
     return std::find(std::begin(keywords), std::end(keywords), keyword) != std::end(keywords);
 }
@@ -28,27 +31,66 @@ bool is_symbol(TokenType symbol) {
                                                 TokenType::CLOSE_BRACES,
                                                 TokenType::ARROW,
                                                 TokenType::DOT,
+                                                TokenType::RANGE,
                                                 TokenType::COMMA,
                                                 TokenType::COLON,
-                                                TokenType::SEMICOLON};
+                                                TokenType::SEMICOLON,
+                                                TokenType::AT};
 
     return std::find(std::begin(symbols), std::end(symbols), symbol) != std::end(symbols);
 }
 
 bool is_operator(TokenType op) {
-    static const std::vector<TokenType> ops{
-        TokenType::ADD,         TokenType::SUB,       TokenType::MUL,           TokenType::DIV,
-        TokenType::MOD,         TokenType::POW,       TokenType::BITWISE_AND,   TokenType::BITWISE_OR,
-        TokenType::BITWISE_NOT, TokenType::ASSIGN,    TokenType::GREATER_EQUAL, TokenType::GREATER_THAN,
-        TokenType::LESS_EQUAL,  TokenType::LESS_THAN, TokenType::EQUAL,         TokenType::AND,
-        TokenType::OR,          TokenType::NOT,       TokenType::ADD_ASSIGN,    TokenType::SUB_ASSIGN,
-        TokenType::MUL_ASSIGN,  TokenType::DIV_ASSIGN};
+    static const std::vector<TokenType> ops{TokenType::ADD,
+                                            TokenType::SUB,
+                                            TokenType::MUL,
+                                            TokenType::DIV,
+                                            TokenType::MOD,
+                                            TokenType::POW,
+                                            TokenType::BITWISE_AND,
+                                            TokenType::BITWISE_OR,
+                                            TokenType::BITWISE_XOR,
+                                            TokenType::BITWISE_NOT,
+                                            TokenType::SHIFT_LEFT,
+                                            TokenType::SHIFT_RIGHT,
+                                            TokenType::ADD_WRAP,
+                                            TokenType::SUB_WRAP,
+                                            TokenType::MUL_WRAP,
+                                            TokenType::ADD_UNCHECKED,
+                                            TokenType::SUB_UNCHECKED,
+                                            TokenType::MUL_UNCHECKED,
+                                            TokenType::ADD_CHECKED,
+                                            TokenType::SUB_CHECKED,
+                                            TokenType::MUL_CHECKED,
+                                            TokenType::ASSIGN,
+                                            TokenType::GREATER_EQUAL,
+                                            TokenType::GREATER_THAN,
+                                            TokenType::LESS_EQUAL,
+                                            TokenType::LESS_THAN,
+                                            TokenType::EQUAL,
+                                            TokenType::NOT_EQUAL,
+                                            TokenType::AND,
+                                            TokenType::OR,
+                                            TokenType::NOT,
+                                            TokenType::ADD_ASSIGN,
+                                            TokenType::SUB_ASSIGN,
+                                            TokenType::MUL_ASSIGN,
+                                            TokenType::DIV_ASSIGN,
+                                            TokenType::MOD_ASSIGN,
+                                            TokenType::BITWISE_AND_ASSIGN,
+                                            TokenType::BITWISE_OR_ASSIGN,
+                                            TokenType::BITWISE_XOR_ASSIGN,
+                                            TokenType::SHIFT_LEFT_ASSIGN,
+                                            TokenType::SHIFT_RIGHT_ASSIGN};
 
     return std::find(std::begin(ops), std::end(ops), op) != std::end(ops);
 }
 
 bool is_statement(TokenType statement) {
-    static const std::vector<TokenType> statements{TokenType::LET, TokenType::MUT, TokenType::RETURN, TokenType::FUNC, TokenType::WHILE};
+    static const std::vector<TokenType> statements{TokenType::LET,   TokenType::MUT,      TokenType::RETURN,
+                                                   TokenType::FUNC,  TokenType::WHILE,    TokenType::FOR,
+                                                   TokenType::BREAK, TokenType::CONTINUE, TokenType::EXPORT,
+                                                   TokenType::AT};
 
     return std::find(std::begin(statements), std::end(statements), statement) != std::end(statements);
 }
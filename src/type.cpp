@@ -4,8 +4,15 @@
 Type Type::none = Type{Ty::NONE, "none"};
 Type Type::invalid = Type{Ty::INVALID, "invalid"};
 
+Type Type::uint8 = Type{Ty::UINT8, "uint8"};
+Type Type::uint16 = Type{Ty::UINT16, "uint16"};
+Type Type::uint32 = Type{Ty::UINT32, "uint32"};
 Type Type::uint64 = Type{Ty::UINT64, "uint64"};
+Type Type::int8 = Type{Ty::INT8, "int8"};
+Type Type::int16 = Type{Ty::INT16, "int16"};
+Type Type::int32 = Type{Ty::INT32, "int32"};
 Type Type::int64 = Type{Ty::INT64, "int64"};
+Type Type::float32 = Type{Ty::FLOAT32, "float32"};
 Type Type::float64 = Type{Ty::FLOAT64, "float64"};
 Type Type::string = Type{Ty::STRING, "string"};
 Type Type::void_ = Type{Ty::VOID, "void"};
@@ -1,4 +1,11 @@
-from utils import compile, run_compiled_program
+import re
+import shutil
+import subprocess
+from pathlib import Path
+
+import pytest
+
+from utils import CHUNG_PATH, compile, function_ir, module_ir, run_compiled_program, run_program
 
 class TestBasic:
     def test_fib(self):
@@ -6,6 +13,71 @@ class TestBasic:
         out, _, _ = run_compiled_program()
         assert int(out) == 102334155 # fib(40)
 
+    def test_fib_optimized(self):
+        compile("examples/fib.chung", "-O2")
+        out, _, _ = run_compiled_program()
+        assert int(out) == 102334155
+
+    def test_remarks(self):
+        compiler_out, _, _ = compile("test/programs/remarks.chung", "-O2", "--remarks=inline")
+        assert "Passed remark from inline in sum at line 8 column 17" in compiler_out
+        assert "'square' inlined into 'sum'" in compiler_out
+        out, _, _ = run_compiled_program()
+        assert out == "30\n"
+
+    def test_debug_info(self):
+        compiler_out, _, _ = compile("examples/fib.chung", "-g", "-fno-omit-frame-pointer")
+        ir = module_ir(compiler_out)
+        fib = function_ir(ir, "fib")
+        assert '"frame-pointer"="all"' in fib.split("\n", 1)[0]
+        assert " !dbg !" in fib
+        assert '"frame-pointer"="all"' in function_ir(ir, "main")
+        assert "!llvm.dbg.cu = " in ir
+        assert re.search(r'!DISubprogram\(name: "fib", [^\n]*line: 1,', ir)
+        assert re.search(r'!DISubprogram\(name: "main", [^\n]*line: 11,', ir)
+        assert re.search(r'!DILocalVariable\(name: "n", arg: 1, [^\n]*line: 1,', ir)
+        out, _, _ = run_compiled_program()
+        assert int(out) == 102334155
+
+    def test_debug_locals(self):
+        compiler_out, _, _ = compile("test/programs/debug_locals.chung", "-g")
+        ir = module_ir(compiler_out)
+        main = function_ir(ir, "main")
+        # Matches debug records (#dbg_declare(ptr ...)) as well as intrinsic calls (@llvm.dbg.declare(metadata ...))
+        declare = re.search(r"dbg[._]declare\((?:metadata )?ptr %total, (?:metadata )?(![0-9]+)", main)
+        assert declare
+        assert re.search(rf'^{declare[1]} = !DILocalVariable\(name: "total", [^\n]*line: 2,', ir, re.M)
+        # The induction variable is a phi, so it's described by value instead of by its address
+        value = re.search(r"dbg[._]value\((?:metadata )?i64 %i, (?:metadata )?(![0-9]+)", main)
+        assert value
+        assert re.search(rf'^{value[1]} = !DILocalVariable\(name: "i", [^\n]*line: 3,', ir, re.M)
+        out, _, _ = run_compiled_program()
+        assert out == "10\n"
+
+    def test_profile_generate(self):
+        profile = Path("chungbuild") / "fib.profraw"
+        profile.unlink(missing_ok=True)
+        compile("examples/fib.chung", "-O2", f"--profile-generate={profile}")
+        out, _, _ = run_compiled_program()
+        assert int(out) == 102334155
+        # The instrumented program writes its counters when it exits
+        assert profile.stat().st_size > 0
+
+        # Merging it and building again reads the counts back
+        if not shutil.which("llvm-profdata"):
+            pytest.skip("llvm-profdata is needed to merge the profile")
+        merged = Path("chungbuild") / "fib.profdata"
+        subprocess.run(["llvm-profdata", "merge", "-o", merged, profile], check=True)
+        compile("examples/fib.chung", "-O2", f"--profile-use={merged}")
+        out, _, _ = run_compiled_program()
+        assert int(out) == 102334155
+
+    def test_profile_use_missing(self):
+        out, err, returncode = run_program(CHUNG_PATH, "parse", "examples/fib.chung",
+                                           "--profile-use=chungbuild/missing.profdata")
+        assert returncode == 1
+        assert 'Profile not found: "chungbuild/missing.profdata" cannot be located' in out + err
+
     def test_mandelbrot(self):
         expected_output = \
 """******************************************************************************
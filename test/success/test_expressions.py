@@ -1,7 +1,146 @@
-from utils import compile, run_compiled_program
+import re
+
+from utils import compile, compile_failure, function_ir, module_ir, run_compiled_program
 
 class TestExpressions:
     def test_block_nested(self):
         compile("test/programs/block_nested.chung")
         out, _, _ = run_compiled_program()
         assert out == "2\n"
+
+    def test_tail_recursion(self):
+        compile("test/programs/tail_recursion.chung")
+        out, _, _ = run_compiled_program()
+        assert out == "50000005000000\n0\n"
+
+    def test_effects(self):
+        compiler_out, _, _ = compile("test/programs/effects.chung")
+        ir = module_ir(compiler_out)
+        for name in ["square", "sum_of_squares"]:
+            attributes = function_ir(ir, name).split("\n")[0]
+            assert "memory(none)" in attributes and "nosync" in attributes and "willreturn" in attributes
+        average = function_ir(ir, "average").split("\n")[0]
+        assert "memory(inaccessiblemem: readwrite)" in average
+        assert "nosync" not in average and "willreturn" not in average
+        first = function_ir(ir, "first").split("\n")[0]
+        assert "memory(" not in first and "nosync" not in first
+        collatz_steps = function_ir(ir, "collatz_steps").split("\n")[0]
+        assert "memory(none)" in collatz_steps and "willreturn" not in collatz_steps
+        describe = function_ir(ir, "describe").split("\n")[0]
+        assert "memory(inaccessiblemem: readwrite)" in describe and "willreturn" in describe
+        out, _, _ = run_compiled_program()
+        assert out == "285\n2\n7\n111\n42"
+
+    def test_tail_call_arrays(self):
+        compiler_out, _, _ = compile("test/programs/tail_call_arrays.chung")
+        ir = module_ir(compiler_out)
+        # The arrays live in the caller's frame, so these calls must not be tail calls
+        assert "tail call" not in function_ir(ir, "shifted_total")
+        assert "tail call" not in function_ir(ir, "sum_three")
+        out, _, _ = run_compiled_program()
+        assert out == "9\n15\n"
+
+    def test_arrays(self):
+        compile("test/programs/arrays.chung")
+        out, err, returncode = run_compiled_program()
+        assert out == "30\n11\n4\n3\n0\n3\n101\n"
+        assert "line 39: index 5 is out of bounds for length 5" in err
+        assert returncode == 1
+
+    def test_immutable_elements(self):
+        out = compile_failure("test/programs/immutable_elements.chung")
+        assert "Parameter 'values' is immutable and its elements cannot be assigned to" in out
+        assert "Variable 'primes' is immutable and its elements cannot be assigned to" in out
+        assert "Only elements of 'mut' arrays can be assigned to, found []int64" in out
+
+    def test_string_literals(self):
+        compiler_out, _, _ = compile("test/programs/string_literals.chung")
+        ir = module_ir(compiler_out)
+        strings = re.findall(r"^@\.str[.\d]* = private unnamed_addr constant .*$", ir, re.M)
+        assert strings == ['@.str = private unnamed_addr constant [14 x i8] c"hello, world\\0A\\00", align 1']
+        assert "call void @print_string(ptr @.str, i64 13)" in function_ir(ir, "greet")
+        assert "ptr @.str, i64 7), i64 6)" in function_ir(ir, "main")
+        out, _, _ = run_compiled_program()
+        assert out == "hello, world\n" * 2 + "world\n" + "hello, world\n"
+
+    def test_number_formatting(self):
+        compile("test/programs/number_formatting.chung")
+        out, _, _ = run_compiled_program()
+        assert out == "-9223372036854775807\n0.1\n2.0\n0.30000000000000004\n12345\n0.5\n"
+
+    def test_vectors(self):
+        compile("test/programs/vectors.chung")
+        out, _, _ = run_compiled_program()
+        assert out == "1\n50\n1\n5\n63\n33\n1\n16.0\n"
+
+    def test_vector_errors(self):
+        out = compile_failure("test/programs/vector_errors.chung")
+        assert "Lane 18446744073709551616 is out of range for 4 lanes" in out
+        assert "Lane 4 is out of range for 4 lanes" in out
+        assert "'select' expects a mask and two values of the same type with as many lanes" in out
+        assert "'select' needs two values to choose between, found void" in out
+
+    def test_narrow_types(self):
+        compile("test/programs/narrow_types.chung")
+        out, _, _ = run_compiled_program()
+        assert out == "44\n300\n1\n-128\n101\n-56\n-128\n-32768\n-2147483648\n-9223372036854775808\n" \
+                      "-9223372036854775808\n6000\n44\n-2\n0\n2147483647\n0.10000000149011612\n36\n18.0\n"
+
+    def test_integer_ops(self):
+        compile("test/programs/integer_ops.chung")
+        out, err, returncode = run_compiled_program()
+        assert out == "3\n-3\n-2\n35\n1.5\n3\n-4\n15\n2\n-6\n1\n544558\n32\n"
+        assert "line 37: division by zero" in err
+        assert returncode == 1
+
+    def test_overflow(self):
+        compile("test/programs/overflow.chung", "--overflow=trap")
+        out, err, returncode = run_compiled_program()
+        assert out == "544558\n44\n-126\n7\n9223372036854775807\n"
+        assert "line 19: integer overflow" in err
+        assert returncode == 1
+
+    def test_power_math(self):
+        compile("test/programs/power_math.chung")
+        out, err, returncode = run_compiled_program()
+        assert out == "1024\n512\n1594323\n-32\n243\n1.4142135623730951\n3.375\n1.4142135623730951\n-3.0\n3.0\n" \
+                      "7.0\n4.0\n7\n5\n5.0\n7.0\n-28\n30\n-4\n-8\n2.0\n-0.5\n"
+        assert "line 2: integer exponent must not be negative, got -1" in err
+        assert returncode == 1
+
+    def test_bit_ops(self):
+        compile("test/programs/bit_ops.chung")
+        out, err, returncode = run_compiled_program()
+        assert out == "18\n2\n61\n32\n16\n513\n67305985\n3\n128\n6\n"
+
+    def test_fast_math(self):
+        compiler_out, _, _ = compile("test/programs/fast_math.chung", "--fp-contract=on")
+        ir = module_ir(compiler_out)
+        sum = function_ir(ir, "sum")
+        assert "fadd fast double" in sum
+        assert '"unsafe-fp-math"="true"' in sum
+        dot = function_ir(ir, "dot")
+        assert "fmul contract double" in dot
+        assert "fadd contract double" in dot
+        horner = function_ir(ir, "horner")
+        assert "fmul double" in horner
+        assert "contract" not in horner and "fadd fast" not in horner
+        assert "call double @llvm.fmuladd.f64(" in function_ir(ir, "main")
+        out, err, returncode = run_compiled_program()
+        assert out == "36.0\n120.0\n13.0\n2.0\n"
+
+    def test_branch_hints(self):
+        compiler_out, _, _ = compile("test/programs/branch_hints.chung")
+        ir = module_ir(compiler_out)
+        assert " cold " in function_ir(ir, "report").split("\n", 1)[0]
+        collatz_steps = function_ir(ir, "collatz_steps")
+        assert " hot " in collatz_steps.split("\n", 1)[0]
+        assert "label %while.exit, !prof !" in collatz_steps
+        main = function_ir(ir, "main")
+        assert ", !prof !" in main
+        # The hint in the expression statement still weighs its short circuit
+        assert any("label %or.rhs" in line and ", !prof !" in line for line in main.splitlines())
+        assert '!{!"branch_weights", i32 2000, i32 1}' in ir
+        assert '!{!"branch_weights", i32 1, i32 2000}' in ir
+        out, err, returncode = run_compiled_program()
+        assert out == "-27\n111\n"
@@ -1,4 +1,8 @@
-from utils import compile, run_compiled_program
+import os
+import pty
+
+from utils import (compile, compile_failure, function_ir, module_ir, read_output, run_compiled_program,
+                   start_compiled_program)
 
 class TestStatements:
     def test_explicit_return(self):
@@ -6,6 +10,25 @@ class TestStatements:
         out, _, _ = run_compiled_program()
         assert int(out) == 3
 
+    def test_linkage(self):
+        compiler_out, _, _ = compile("test/programs/linkage.chung")
+        ir = module_ir(compiler_out)
+        assert function_ir(ir, "add_one").startswith("define internal fastcc i64 @add_one(")
+        assert function_ir(ir, "triple").startswith("define i64 @triple(")
+        assert function_ir(ir, "main").startswith("define void @main(")
+        main = function_ir(ir, "main")
+        assert "call fastcc i64 @add_one(" in main
+        assert "call i64 @triple(" in main
+        out, _, _ = run_compiled_program()
+        assert out == "13\n"
+
+    def test_loop_hint_errors(self):
+        out = compile_failure("test/programs/loop_hint_errors.chung")
+        assert "Count for '@unroll' must be at most 4294967295" in out
+        assert "Count for '@vectorize' must be at most 4294967295" in out
+        assert "Duplicate loop attribute '@unroll'" in out
+        assert "Unknown expression attribute '@unroll'" in out
+
     def test_while_0_to_10(self):
         compile("test/programs/while_0_to_10.chung")
         out, _, _ = run_compiled_program()
@@ -15,3 +38,81 @@ class TestStatements:
         compile("test/programs/variable_initialization.chung")
         out, _, _ = run_compiled_program()
         assert out == "1\n2\n"
+
+    def test_read_stdin(self):
+        compile("test/programs/read_stdin.chung")
+        out, _, _ = run_compiled_program(input="chung\r\n1 2\n  -3\t40\n")
+        assert out == "Name? chung\n40\n"
+
+    def test_embedded_nul(self):
+        compile("test/programs/embedded_nul.chung")
+        out, _, _ = run_compiled_program(input="chung\n")
+        assert out == "one\0two\n8\n" + "\0two\n" + "name\0? chung\n" + "one\0two\n8\n"
+
+    def test_uninitialized(self):
+        compiler_out, _, _ = compile("test/programs/uninitialized.chung")
+        main = function_ir(module_ir(compiler_out), "main")
+        assert "undef" not in main
+        assert "call void @print_string(ptr null, i64 0)" in main
+        assert "store { ptr, i64 } zeroinitializer, ptr %greeting" in main
+        out, _, _ = run_compiled_program()
+        assert out == "0\nhello\n"
+
+    def test_output_buffer(self):
+        compile("test/programs/output_buffer.chung")
+        out, err, returncode = run_compiled_program(input="0\n5\n")
+        assert out == "1\npartial line\n"
+        assert "line 9: index 5 is out of bounds for length 3" in err
+        assert returncode == 1
+
+    def test_output_buffer_flush(self):
+        compile("test/programs/output_buffer.chung")
+        program = start_compiled_program()
+        # Not a terminal, so only flush() and the panic write anything out
+        assert read_output(program.stdout.fileno(), timeout=0.2) == ""
+        program.stdin.write(b"0\n")
+        program.stdin.flush()
+        assert read_output(program.stdout.fileno()) == "1\npartial"
+        out, err = program.communicate(b"5\n", timeout=5)
+        assert out == b" line\n"
+        assert b"line 9: index 5 is out of bounds for length 3" in err
+
+    def test_output_buffer_tty(self):
+        compile("test/programs/output_buffer.chung")
+        main, replica = pty.openpty()
+        program = start_compiled_program(stdout=replica)
+        os.close(replica)
+        # Every line shows up as soon as it's printed, the terminal turns "\n" into "\r\n"
+        assert read_output(main) == "1\r\n"
+        program.stdin.write(b"0\n")
+        program.stdin.flush()
+        assert read_output(main) == "partial"
+        program.communicate(b"1\n", timeout=5)
+        assert read_output(main) == " line\r\n2\r\n"
+        os.close(main)
+
+    def test_file_io(self):
+        compile("test/programs/file_io.chung")
+        out, _, _ = run_compiled_program()
+        assert out == "1\n" + "first\nsecond\n" * 3
+
+    def test_for_loops(self):
+        compile("test/programs/for_loops.chung")
+        out, err, returncode = run_compiled_program()
+        assert out == "32.0\n1\n9\n25\n4\n10\n0\n0\n3\n"
+        assert "line 11: range step must be positive, got 0" in err
+        assert returncode == 1
+
+    def test_loop_control(self):
+        compiler_out, _, _ = compile("test/programs/loop_control.chung")
+        ir = module_ir(compiler_out)
+        assert ir.count("!llvm.loop !") == 4
+        assert '!{!"llvm.loop.unroll.count", i32 4}' in ir
+        assert '!{!"llvm.loop.vectorize.enable", i1 false}' in ir
+        assert '!{!"llvm.loop.unroll.disable"}' in ir
+        assert '!{!"llvm.loop.vectorize.enable", i1 true}' in ir
+        assert '!{!"llvm.loop.vectorize.width", i32 4}' in ir
+        assert '!{!"llvm.loop.interleave.count", i32 2}' in ir
+        assert '!{!"llvm.loop.distribute.enable", i1 true}' in ir
+        out, _, _ = run_compiled_program()
+        assert out == "3\n-1\n43\n10\n84\n"
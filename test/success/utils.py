@@ -1,18 +1,51 @@
+import os
+import re
+import select
 import subprocess
 from pathlib import Path
 
 CHUNG_PATH = Path() / "build" / "chung"
 COMPILED_PATH = Path() / "chungbuild" / "output.out"
 
-def run_program(path: Path, *args):
-    result = subprocess.run([path, *args], capture_output=True, text=True, timeout=5, encoding="latin-1")
+def run_program(path: Path, *args, input: str | None = None):
+    result = subprocess.run([path, *args], input=input, capture_output=True, text=True, timeout=5, encoding="latin-1")
 
     return result.stdout, result.stderr, result.returncode
 
-def compile(path: str):
-    stdout, stderr, returncode = run_program(CHUNG_PATH, "parse", path)
+def compile(path: str, *options: str):
+    stdout, stderr, returncode = run_program(CHUNG_PATH, "parse", path, *options)
     assert returncode == 0, "Chunglang compiler failed with nonzero exit code"
     return stdout, stderr, returncode
 
-def run_compiled_program():
-    return run_program(COMPILED_PATH)
+def compile_failure(path: str, *options: str):
+    stdout, _, returncode = run_program(CHUNG_PATH, "parse", path, *options)
+    assert returncode != 0, "Chunglang compiler accepted a program it should reject"
+    return stdout
+
+def run_compiled_program(input: str | None = None):
+    return run_program(COMPILED_PATH, input=input)
+
+def start_compiled_program(stdout=subprocess.PIPE):
+    # For tests that watch the output while the program is still running
+    return subprocess.Popen([COMPILED_PATH], stdin=subprocess.PIPE, stdout=stdout, stderr=subprocess.PIPE)
+
+def read_output(fd: int, timeout: float = 5):
+    # Whatever the program has written so far, or "" if nothing shows up in time
+    ready, _, _ = select.select([fd], [], [], timeout)
+    return os.read(fd, 4096).decode("latin-1") if ready else ""
+
+def module_ir(compiler_out: str):
+    # The compiler prints the module before optimizing it, between the "Module IR" banner and "Compiling <file>"
+    ir = compiler_out[compiler_out.index("Module IR"):]
+    return ir[ir.index("\n") + 1:ir.index("\nCompiling ")]
+
+def function_ir(ir: str, name: str):
+    # The define line with its attribute groups spelled out, then the body
+    match = re.search(r"^define [^\n]*@" + re.escape(name) + r"\(.*?^}$", ir, re.M | re.S)
+    assert match, f"No function named '{name}' in the module"
+    define = match.group(0)
+    header = define.split("\n", 1)[0]
+    for group in re.findall(r"#\d+", header):
+        attributes = re.search(r"^attributes " + group + r" = \{ (.*) \}$", ir, re.M)
+        header += " " + attributes.group(1)
+    return header + "\n" + define.split("\n", 1)[1]